@@ -0,0 +1,357 @@
+#include "BatchProcessor.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace zraw {
+
+namespace {
+
+// File extensions picked up when scanning a directory or glob
+const QStringList kRawFilters = {
+    "*.cr2", "*.cr3", "*.nef", "*.arw", "*.dng", "*.raf", "*.orf", "*.rw2"
+};
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int defaultThreadCount(int divisor) {
+    unsigned int cores = std::thread::hardware_concurrency();
+    if (cores == 0) {
+        cores = 2;
+    }
+    return std::max(1, static_cast<int>(cores) / divisor);
+}
+
+} // namespace
+
+BatchProcessor::BatchProcessor(std::shared_ptr<RenderBackend> pipeline, const Settings& settings)
+    : m_pipeline(std::move(pipeline)),
+      m_settings(settings),
+      m_decodeQueue(settings.queueDepth),
+      m_renderQueue(settings.queueDepth),
+      m_encodeQueue(settings.queueDepth),
+      m_activeDecoders(0),
+      m_completed(0), m_failed(0) {
+    // LibRaw demosaic is the most expensive stage, give it the larger share
+    if (m_settings.decodeThreads <= 0) {
+        m_settings.decodeThreads = defaultThreadCount(2);
+    }
+    if (m_settings.encodeThreads <= 0) {
+        m_settings.encodeThreads = defaultThreadCount(4);
+    }
+}
+
+BatchProcessor::~BatchProcessor() {
+    m_decodeQueue.close();
+    m_renderQueue.close();
+    m_encodeQueue.close();
+    joinWorkers();
+}
+
+void BatchProcessor::start() {
+    m_activeDecoders = m_settings.decodeThreads;
+    for (int i = 0; i < m_settings.decodeThreads; ++i) {
+        m_decodeThreads.emplace_back(&BatchProcessor::decodeWorker, this);
+    }
+    for (int i = 0; i < m_settings.encodeThreads; ++i) {
+        m_encodeThreads.emplace_back(&BatchProcessor::encodeWorker, this);
+    }
+
+    std::cout << "Batch pipeline started: " << m_settings.decodeThreads << " decode, "
+              << m_settings.encodeThreads << " encode threads" << std::endl;
+}
+
+bool BatchProcessor::submit(const Job& job, CompletionCallback callback) {
+    auto item = std::make_shared<WorkItem>();
+    item->job = job;
+    item->callback = std::move(callback);
+    item->result.inputFile = job.inputFile;
+    item->result.outputFile = job.outputFile;
+    return m_decodeQueue.push(std::move(item));
+}
+
+void BatchProcessor::finish() {
+    m_decodeQueue.close();
+}
+
+void BatchProcessor::decodeWorker() {
+    // Each worker keeps its own LibRaw instance alive across files
+    RawProcessor rawProcessor;
+
+    while (auto next = m_decodeQueue.pop()) {
+        WorkItemPtr item = std::move(*next);
+        auto start = Clock::now();
+
+        if (!rawProcessor.loadRaw(item->job.inputFile.toStdString()) ||
+            !rawProcessor.processToRGB(item->job.decodeOptions)) {
+            item->result.error = rawProcessor.lastError();
+        } else {
+            item->image = rawProcessor.getImageBuffer();
+        }
+        item->result.decodeMs = elapsedMs(start);
+
+        if (!item->image) {
+            complete(*item);
+            continue;
+        }
+
+        if (!m_renderQueue.push(item)) {
+            item->result.error = "Batch pipeline shut down";
+            complete(*item);
+        }
+    }
+
+    // Last decoder out lets the render loop finish
+    if (--m_activeDecoders == 0) {
+        m_renderQueue.close();
+    }
+}
+
+void BatchProcessor::runRenderLoop() {
+    // Image whose readback is queued on the GPU but not collected yet
+    WorkItemPtr pending;
+
+    for (;;) {
+        // Nothing to overlap the readback with: collect it before waiting
+        if (pending && m_renderQueue.size() == 0) {
+            collectItem(pending);
+            pending.reset();
+        }
+
+        auto next = m_renderQueue.pop();
+        if (!next) {
+            break;
+        }
+
+        WorkItemPtr item = std::move(*next);
+        auto start = Clock::now();
+        bool rendered = renderItem(*item);
+        item->result.renderMs = elapsedMs(start);
+
+        // The GPU is now busy with this image; the previous one's pixels
+        // should be ready to map without a stall
+        if (pending) {
+            collectItem(pending);
+            pending.reset();
+        }
+
+        if (!rendered) {
+            complete(*item);
+        } else if (item->downloadPending) {
+            pending = std::move(item);
+        } else {
+            queueEncode(item);
+        }
+    }
+
+    if (pending) {
+        collectItem(pending);
+    }
+
+    m_encodeQueue.close();
+    joinWorkers();
+}
+
+bool BatchProcessor::renderItem(WorkItem& item) {
+    applyAdjustments(*m_pipeline, item.job.adjustments);
+
+    if (!m_pipeline->uploadImage(item.image)) {
+        item.result.error = "Failed to upload image";
+        return false;
+    }
+
+    if (!m_pipeline->process()) {
+        item.result.error = "Failed to process image";
+        return false;
+    }
+
+    // The decoded image is no longer needed; release it early
+    item.image.reset();
+
+    // Queue the readback if the backend can, collectItem() picks it up
+    if (m_pipeline->beginDownload()) {
+        item.downloadPending = true;
+        return true;
+    }
+
+    item.image = m_pipeline->downloadImage();
+    if (!item.image) {
+        item.result.error = "Failed to download processed image";
+        return false;
+    }
+
+    return true;
+}
+
+void BatchProcessor::collectItem(const WorkItemPtr& item) {
+    auto start = Clock::now();
+    item->image = m_pipeline->finishDownload();
+    item->downloadPending = false;
+    item->result.renderMs += elapsedMs(start);
+
+    if (!item->image) {
+        item->result.error = "Failed to download processed image";
+        complete(*item);
+        return;
+    }
+    queueEncode(item);
+}
+
+void BatchProcessor::queueEncode(const WorkItemPtr& item) {
+    if (!m_encodeQueue.push(item)) {
+        item->result.error = "Batch pipeline shut down";
+        complete(*item);
+    }
+}
+
+void BatchProcessor::encodeWorker() {
+    ImageExporter exporter;
+
+    while (auto next = m_encodeQueue.pop()) {
+        WorkItemPtr item = std::move(*next);
+        auto start = Clock::now();
+
+        if (exporter.exportImage(item->image, item->job.outputFile,
+                                 item->job.format, item->job.quality)) {
+            item->result.success = true;
+        } else {
+            item->result.error = "Failed to export image";
+        }
+        item->result.encodeMs = elapsedMs(start);
+        item->image.reset();
+
+        complete(*item);
+    }
+}
+
+void BatchProcessor::complete(WorkItem& item) {
+    item.image.reset();
+    if (item.result.success) {
+        ++m_completed;
+    } else {
+        ++m_failed;
+    }
+    if (item.callback) {
+        item.callback(item.result);
+    }
+}
+
+void BatchProcessor::joinWorkers() {
+    for (auto& thread : m_decodeThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    for (auto& thread : m_encodeThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    m_decodeThreads.clear();
+    m_encodeThreads.clear();
+}
+
+QStringList BatchProcessor::collectInputs(const QString& spec) {
+    QStringList inputs;
+    QFileInfo specInfo(spec);
+
+    if (specInfo.isDir()) {
+        // Directory: every RAW file directly inside it
+        QDir dir(spec);
+        for (const QString& name : dir.entryList(kRawFilters, QDir::Files, QDir::Name)) {
+            inputs.append(dir.absoluteFilePath(name));
+        }
+    } else if (spec.contains('*') || spec.contains('?') || spec.contains('[')) {
+        // Glob: pattern applies to the file name part only
+        QDir dir(specInfo.absolutePath());
+        for (const QString& name : dir.entryList(QStringList{specInfo.fileName()},
+                                                 QDir::Files, QDir::Name)) {
+            inputs.append(dir.absoluteFilePath(name));
+        }
+    } else if (specInfo.isFile()) {
+        // List file: one path per line, '#' starts a comment
+        QFile file(spec);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            std::cerr << "Failed to open batch list: " << spec.toStdString() << std::endl;
+            return inputs;
+        }
+
+        QDir baseDir = specInfo.absoluteDir();
+        QTextStream in(&file);
+        while (!in.atEnd()) {
+            QString line = in.readLine().trimmed();
+            if (line.isEmpty() || line.startsWith('#')) {
+                continue;
+            }
+            inputs.append(baseDir.absoluteFilePath(line));
+        }
+    } else {
+        std::cerr << "Batch input not found: " << spec.toStdString() << std::endl;
+    }
+
+    QSet<QString> seen;
+    QStringList unique;
+    for (const QString& input : inputs) {
+        QString path = QDir::cleanPath(input);
+        if (seen.contains(path)) {
+            std::cerr << "Skipping duplicate batch input: " << path.toStdString() << std::endl;
+            continue;
+        }
+        seen.insert(path);
+        unique.append(path);
+    }
+    return unique;
+}
+
+QStringList BatchProcessor::outputBaseNames(const QStringList& inputs) {
+    // Every plain base name is taken first, so a suffixed name never lands
+    // on a later input's own name
+    QSet<QString> taken;
+    for (const QString& input : inputs) {
+        taken.insert(QFileInfo(input).completeBaseName().toLower());
+    }
+
+    QSet<QString> used;
+    QStringList names;
+    for (const QString& input : inputs) {
+        QString name = QFileInfo(input).completeBaseName();
+        if (used.contains(name.toLower())) {
+            QString base = name;
+            for (int n = 2; taken.contains(name.toLower()); ++n) {
+                name = base + "-" + QString::number(n);
+            }
+            taken.insert(name.toLower());
+            std::cerr << "Output name " << base.toStdString() << " is already used, writing "
+                      << input.toStdString() << " as " << name.toStdString() << std::endl;
+        }
+        used.insert(name.toLower());
+        names.append(name);
+    }
+    return names;
+}
+
+void BatchProcessor::applyAdjustments(RenderBackend& pipeline, const XMPHandler::Adjustments& adjustments) {
+    pipeline.setExposure(adjustments.exposure);
+    pipeline.setContrast(adjustments.contrast);
+    pipeline.setSharpness(adjustments.sharpness);
+    pipeline.setTemperature(adjustments.temperature);
+    pipeline.setTint(adjustments.tint);
+    pipeline.setHighlights(adjustments.highlights);
+    pipeline.setShadows(adjustments.shadows);
+    pipeline.setVibrance(adjustments.vibrance);
+    pipeline.setSaturation(adjustments.saturation);
+    pipeline.setHighlightContrast(adjustments.highlightContrast);
+    pipeline.setMidtoneContrast(adjustments.midtoneContrast);
+    pipeline.setShadowContrast(adjustments.shadowContrast);
+}
+
+} // namespace zraw
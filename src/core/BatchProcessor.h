@@ -0,0 +1,145 @@
+#pragma once
+
+#include "BoundedQueue.h"
+#include "ImageBuffer.h"
+#include "ImageExporter.h"
+#include "RawProcessor.h"
+#include "RenderBackend.h"
+#include "XMPHandler.h"
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace zraw {
+
+/**
+ * Pipelined batch renderer
+ * Overlaps LibRaw decoding on N worker threads, rendering on the thread that
+ * owns the render backend (the OpenGL context for the GPU pipeline) and
+ * encoding on M worker threads. Stages are
+ * connected by bounded queues so at most a few images are in flight at once.
+ * With a backend that supports asynchronous readback, image N is collected
+ * from the GPU only after image N+1 was uploaded and submitted.
+ */
+class BatchProcessor {
+public:
+    struct Settings {
+        int decodeThreads = 0;      // 0 = pick from hardware concurrency
+        int encodeThreads = 0;      // 0 = pick from hardware concurrency
+        size_t queueDepth = 2;      // Images buffered between two stages
+    };
+
+    struct Job {
+        QString inputFile;
+        QString outputFile;
+        XMPHandler::Adjustments adjustments;
+        RawProcessor::DecodeOptions decodeOptions;
+        ImageExporter::Format format = ImageExporter::Format::TIFF;
+        int quality = 95;
+    };
+
+    struct Result {
+        QString inputFile;
+        QString outputFile;
+        bool success = false;
+        std::string error;
+
+        // Per-stage wall time in milliseconds
+        double decodeMs = 0.0;
+        double renderMs = 0.0;
+        double encodeMs = 0.0;
+    };
+
+    using CompletionCallback = std::function<void(const Result&)>;
+
+    BatchProcessor(std::shared_ptr<RenderBackend> pipeline, const Settings& settings);
+    ~BatchProcessor();
+
+    /**
+     * Start decode and encode worker threads
+     */
+    void start();
+
+    /**
+     * Queue a job; blocks while the decode queue is full, so call it from a
+     * thread other than the one running runRenderLoop()
+     * @param callback Invoked from a worker thread once the job finished or failed
+     * @return false if finish() was already called
+     */
+    bool submit(const Job& job, CompletionCallback callback = nullptr);
+
+    /**
+     * Signal that no more jobs will be submitted
+     */
+    void finish();
+
+    /**
+     * Render decoded images until finish() was called and all queues drained
+     * With the GPU backend this must be the thread whose OpenGL context is current.
+     */
+    void runRenderLoop();
+
+    // Counters (valid after runRenderLoop() returns)
+    int completedCount() const { return m_completed.load(); }
+    int failedCount() const { return m_failed.load(); }
+
+    /**
+     * Expand a directory, glob pattern or list file into input paths
+     * Directories and globs are scanned for RAW files; list files contain one
+     * path per line (relative paths are resolved against the list file).
+     * A file listed more than once is kept once.
+     */
+    static QStringList collectInputs(const QString& spec);
+
+    /**
+     * Output base names for inputs written into one directory
+     * Inputs sharing a base name (a/IMG_1.ARW and b/IMG_1.ARW, or X.CR2 and
+     * X.DNG) would overwrite each other's output; later ones get a -2, -3, ...
+     * suffix. Names are compared case-insensitively.
+     */
+    static QStringList outputBaseNames(const QStringList& inputs);
+
+    /**
+     * Apply a full set of adjustments to a render backend
+     */
+    static void applyAdjustments(RenderBackend& pipeline, const XMPHandler::Adjustments& adjustments);
+
+private:
+    struct WorkItem {
+        Job job;
+        CompletionCallback callback;
+        std::shared_ptr<ImageBuffer> image;
+        Result result;
+        bool downloadPending = false;  // Readback queued with beginDownload()
+    };
+    using WorkItemPtr = std::shared_ptr<WorkItem>;
+
+    std::shared_ptr<RenderBackend> m_pipeline;
+    Settings m_settings;
+
+    BoundedQueue<WorkItemPtr> m_decodeQueue;
+    BoundedQueue<WorkItemPtr> m_renderQueue;
+    BoundedQueue<WorkItemPtr> m_encodeQueue;
+
+    std::vector<std::thread> m_decodeThreads;
+    std::vector<std::thread> m_encodeThreads;
+    std::atomic<int> m_activeDecoders;
+
+    std::atomic<int> m_completed;
+    std::atomic<int> m_failed;
+
+    void decodeWorker();
+    void encodeWorker();
+    bool renderItem(WorkItem& item);
+    void collectItem(const WorkItemPtr& item);
+    void queueEncode(const WorkItemPtr& item);
+    void complete(WorkItem& item);
+    void joinWorkers();
+};
+
+} // namespace zraw
@@ -0,0 +1,110 @@
+#include "BufferPool.h"
+#include <cstdlib>
+
+namespace zraw {
+
+namespace {
+
+// Bucket granularity: fine for thumbnails, coarse enough for full-size
+// images of one camera to share a bucket
+const size_t kSmallGranularity = 64 * 1024;
+const size_t kLargeGranularity = 1024 * 1024;
+const size_t kLargeThreshold = 16 * 1024 * 1024;
+
+size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+BufferPool& BufferPool::instance() {
+    static BufferPool pool;
+    return pool;
+}
+
+BufferPool::BufferPool()
+    : m_cacheLimit(size_t(1) << 30) {
+}
+
+BufferPool::~BufferPool() {
+    trim();
+}
+
+size_t BufferPool::bucketSize(size_t bytes) {
+    if (bytes == 0) {
+        bytes = 1;
+    }
+    return roundUp(bytes, bytes >= kLargeThreshold ? kLargeGranularity : kSmallGranularity);
+}
+
+void* BufferPool::acquire(size_t bytes, size_t& bucketBytes) {
+    bucketBytes = bucketSize(bytes);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.requests;
+
+        auto it = m_freeBlocks.find(bucketBytes);
+        if (it != m_freeBlocks.end() && !it->second.empty()) {
+            void* block = it->second.back();
+            it->second.pop_back();
+            m_stats.bytesCached -= bucketBytes;
+            ++m_stats.poolHits;
+            return block;
+        }
+
+        m_stats.bytesAllocated += bucketBytes;
+    }
+
+    // Bucket sizes are multiples of the alignment, as aligned_alloc requires
+    return std::aligned_alloc(kAlignment, bucketBytes);
+}
+
+void BufferPool::release(void* block, size_t bucketBytes) {
+    if (!block) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stats.bytesCached + bucketBytes <= m_cacheLimit) {
+            m_freeBlocks[bucketBytes].push_back(block);
+            m_stats.bytesCached += bucketBytes;
+            return;
+        }
+    }
+
+    std::free(block);
+}
+
+void BufferPool::setCacheLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cacheLimit = bytes;
+
+    // Drop the largest blocks first until under the new limit
+    for (auto it = m_freeBlocks.rbegin(); it != m_freeBlocks.rend() && m_stats.bytesCached > m_cacheLimit; ++it) {
+        while (!it->second.empty() && m_stats.bytesCached > m_cacheLimit) {
+            std::free(it->second.back());
+            it->second.pop_back();
+            m_stats.bytesCached -= it->first;
+        }
+    }
+}
+
+BufferPool::Stats BufferPool::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void BufferPool::trim() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& bucket : m_freeBlocks) {
+        for (void* block : bucket.second) {
+            std::free(block);
+        }
+    }
+    m_freeBlocks.clear();
+    m_stats.bytesCached = 0;
+}
+
+} // namespace zraw
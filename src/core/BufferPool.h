@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace zraw {
+
+/**
+ * Process-wide pool of large pixel allocations
+ * Blocks are 64-byte aligned (SIMD friendly), not zero-initialized, and
+ * rounded up to a size bucket so images of the same dimensions reuse each
+ * other's memory across decodes, renders and downloads. Released blocks are
+ * cached up to a byte limit; beyond it they go back to the system.
+ */
+class BufferPool {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    struct Stats {
+        uint64_t bytesAllocated = 0;  // Bytes requested from the system so far
+        uint64_t bytesCached = 0;     // Bytes currently held for reuse
+        uint64_t requests = 0;        // acquire() calls
+        uint64_t poolHits = 0;        // acquire() calls served from the cache
+    };
+
+    static BufferPool& instance();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * Get a block of at least the given size
+     * @param bucketBytes Receives the actual block size; pass it to release()
+     * @return nullptr if the system is out of memory
+     */
+    void* acquire(size_t bytes, size_t& bucketBytes);
+
+    /**
+     * Return a block obtained from acquire()
+     */
+    void release(void* block, size_t bucketBytes);
+
+    // Upper bound for cached bytes (default 1 GiB); 0 disables caching
+    void setCacheLimit(size_t bytes);
+
+    Stats stats() const;
+
+    // Free all cached blocks
+    void trim();
+
+private:
+    BufferPool();
+    ~BufferPool();
+
+    static size_t bucketSize(size_t bytes);
+
+    mutable std::mutex m_mutex;
+    std::map<size_t, std::vector<void*>> m_freeBlocks;  // By bucket size
+    size_t m_cacheLimit;
+    Stats m_stats;
+};
+
+} // namespace zraw
@@ -14,7 +14,12 @@ void CLIHandler::setupParser() {
         "ZRaw Developer - GPU-accelerated RAW photo editor for Linux\n\n"
         "Usage modes:\n"
         "  GUI mode:      zraw-developer [input.raw]\n"
-        "  Headless mode: zraw-developer --headless -i input.raw -o output.tiff [options]"
+        "  Headless mode: zraw-developer --headless -i input.raw -o output.tiff [options]\n"
+        "  Batch mode:    zraw-developer --batch <dir|glob|list-file> -o output-dir [options]\n"
+        "  Daemon mode:   zraw-developer --serve /run/zraw.sock [--decode-threads N]\n"
+        "  LUT export:    zraw-developer --export-lut look.cube [adjustments]\n"
+        "  Statistics:    zraw-developer --stats json -i input.raw [-o output.tiff] [options]\n"
+        "  Benchmark:     zraw-developer --benchmark-transfers"
     );
     
     m_parser.addHelpOption();
@@ -39,6 +44,84 @@ void CLIHandler::setupParser() {
         "Run in headless mode (no GUI, process and exit)"
     ));
     
+    m_parser.addOption(QCommandLineOption(
+        "batch",
+        "Process a directory, glob pattern or list file of RAW files (implies --headless)",
+        "dir|glob|list-file"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "serve",
+        "Run as a render daemon accepting JSON jobs on a Unix socket (implies --headless)",
+        "socket"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "benchmark-transfers",
+        "Measure GPU upload/download throughput of RGB vs. padded RGBA transfers and exit"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "export-lut",
+        "Write the color adjustments as a 33^3 .cube LUT (without sharpening) and exit",
+        "file"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "stats",
+        "Print histograms and clipping counts of the developed image (implies --headless, gpu backend)",
+        "json"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "stats-bins",
+        "Histogram bins for --stats: 256 or 1024 (default: 256)",
+        "count",
+        "256"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "stats-scale",
+        "Resolution measured by --stats: full or proxy (default: full)",
+        "scale",
+        "full"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "decode-threads",
+        "Batch/daemon mode: number of RAW decode threads (0 = automatic)",
+        "count",
+        "0"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "encode-threads",
+        "Batch/daemon mode: number of encode threads (0 = automatic)",
+        "count",
+        "0"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "backend",
+        "Headless mode: render backend, gpu or cpu (default: gpu)",
+        "backend",
+        "gpu"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "decode-scale",
+        "RAW decode scale: 1, 1/2 (no demosaic) or 1/4 (default: 1)",
+        "scale",
+        "1"
+    ));
+    
+    m_parser.addOption(QCommandLineOption(
+        "demosaic",
+        "Demosaic algorithm: auto, linear, vng, ppg, ahd, dcb, dht, aahd (default: auto)",
+        "algorithm",
+        "auto"
+    ));
+    
     // Adjustments
     m_parser.addOption(QCommandLineOption(
         {"e", "exposure"},
@@ -61,6 +144,13 @@ void CLIHandler::setupParser() {
         "0.0"
     ));
     
+    m_parser.addOption(QCommandLineOption(
+        "sharpen-radius",
+        "Sharpening radius in pixels (0.5 to 4.0, default: 0.7)",
+        "value",
+        "0.7"
+    ));
+    
     // Output format
     m_parser.addOption(QCommandLineOption(
         {"f", "format"},
@@ -100,12 +190,44 @@ bool CLIHandler::parse(const QStringList& arguments) {
         }
     }
     
-    // Headless mode
-    m_options.headless = m_parser.isSet("headless");
+    // Headless mode (batch mode is always headless)
+    if (m_parser.isSet("batch")) {
+        m_options.batchInput = m_parser.value("batch");
+    }
+    if (m_parser.isSet("serve")) {
+        m_options.serveSocket = m_parser.value("serve");
+    }
+    m_options.benchmarkTransfers = m_parser.isSet("benchmark-transfers");
+    if (m_parser.isSet("export-lut")) {
+        m_options.exportLut = m_parser.value("export-lut");
+    }
+    if (m_parser.isSet("stats")) {
+        m_options.stats = m_parser.value("stats").toLower();
+    }
+    m_options.headless = m_parser.isSet("headless") || !m_options.batchInput.isEmpty() ||
+                         !m_options.serveSocket.isEmpty() || m_options.benchmarkTransfers ||
+                         !m_options.exportLut.isEmpty() || !m_options.stats.isEmpty();
     
     // In headless mode, output file is required
-    if (m_options.headless) {
+    if (m_options.benchmarkTransfers) {
+        // Benchmark mode - synthetic image, nothing to read or write
+    } else if (!m_options.exportLut.isEmpty()) {
+        // LUT export mode - the look doesn't depend on an image
+    } else if (!m_options.serveSocket.isEmpty()) {
+        // Daemon mode - inputs and outputs arrive with each job
+        if (!m_options.batchInput.isEmpty()) {
+            qCritical() << "Error: --serve and --batch cannot be combined";
+            return false;
+        }
+    } else if (!m_options.batchInput.isEmpty()) {
         if (!m_parser.isSet("output")) {
+            qCritical() << "Error: --output directory is required in batch mode";
+            return false;
+        }
+        m_options.outputFile = m_parser.value("output");
+    } else if (m_options.headless) {
+        // Statistics alone don't need an output file
+        if (!m_parser.isSet("output") && m_options.stats.isEmpty()) {
             qCritical() << "Error: --output is required in headless mode";
             return false;
         }
@@ -142,6 +264,80 @@ bool CLIHandler::parse(const QStringList& arguments) {
         return false;
     }
     
+    m_options.sharpenRadius = m_parser.value("sharpen-radius").toFloat(&ok);
+    if (!ok || m_options.sharpenRadius < 0.5f || m_options.sharpenRadius > 4.0f) {
+        qCritical() << "Error: Sharpen radius must be between 0.5 and 4.0";
+        return false;
+    }
+    
+    // Batch worker threads
+    m_options.decodeThreads = m_parser.value("decode-threads").toInt(&ok);
+    if (!ok || m_options.decodeThreads < 0) {
+        qCritical() << "Error: Decode threads must be 0 or a positive number";
+        return false;
+    }
+    
+    m_options.encodeThreads = m_parser.value("encode-threads").toInt(&ok);
+    if (!ok || m_options.encodeThreads < 0) {
+        qCritical() << "Error: Encode threads must be 0 or a positive number";
+        return false;
+    }
+    
+    // Render backend
+    m_options.backend = m_parser.value("backend").toLower();
+    if (m_options.backend != "gpu" && m_options.backend != "cpu") {
+        qCritical() << "Error: Backend must be gpu or cpu";
+        return false;
+    }
+    if (m_options.backend == "cpu" && !m_options.headless) {
+        qCritical() << "Error: --backend cpu is only available in headless mode";
+        return false;
+    }
+    if (m_options.backend == "cpu" && !m_options.exportLut.isEmpty()) {
+        qCritical() << "Error: --export-lut requires the gpu backend";
+        return false;
+    }
+    
+    // Statistics
+    if (!m_options.stats.isEmpty()) {
+        if (m_options.stats != "json") {
+            qCritical() << "Error: Stats format must be json";
+            return false;
+        }
+        if (m_options.backend == "cpu") {
+            qCritical() << "Error: --stats requires the gpu backend";
+            return false;
+        }
+        if (!m_options.batchInput.isEmpty() || !m_options.serveSocket.isEmpty() ||
+            !m_options.exportLut.isEmpty() || m_options.benchmarkTransfers) {
+            qCritical() << "Error: --stats is only available for single images";
+            return false;
+        }
+    }
+    m_options.statsBins = m_parser.value("stats-bins").toInt(&ok);
+    if (!ok || (m_options.statsBins != 256 && m_options.statsBins != 1024)) {
+        qCritical() << "Error: Stats bins must be 256 or 1024";
+        return false;
+    }
+    QString statsScale = m_parser.value("stats-scale").toLower();
+    if (statsScale != "full" && statsScale != "proxy") {
+        qCritical() << "Error: Stats scale must be full or proxy";
+        return false;
+    }
+    m_options.statsProxy = statsScale == "proxy";
+    
+    // RAW decoding
+    if (!RawProcessor::parseDecodeScale(m_parser.value("decode-scale").toStdString(),
+                                        m_options.decodeOptions.scale)) {
+        qCritical() << "Error: Decode scale must be 1, 1/2 or 1/4";
+        return false;
+    }
+    if (!RawProcessor::parseDemosaic(m_parser.value("demosaic").toLower().toStdString(),
+                                     m_options.decodeOptions.demosaic)) {
+        qCritical() << "Error: Demosaic must be auto, linear, vng, ppg, ahd, dcb, dht or aahd";
+        return false;
+    }
+    
     // Output format
     m_options.format = m_parser.value("format").toLower();
     if (m_options.format != "tiff" && m_options.format != "jpeg" && 
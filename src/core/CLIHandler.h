@@ -1,5 +1,6 @@
 #pragma once
 
+#include "RawProcessor.h"
 #include <QString>
 #include <QCommandLineParser>
 #include <memory>
@@ -17,10 +18,38 @@ public:
         QString outputFile;
         bool headless = false;
         
+        // Batch mode (headless): directory, glob or list file of inputs;
+        // outputFile is then the output directory
+        QString batchInput;
+        int decodeThreads = 0;      // 0 = automatic
+        int encodeThreads = 0;      // 0 = automatic
+        
+        // Daemon mode (headless): Unix socket to accept render jobs on
+        QString serveSocket;
+        
+        // Benchmark mode (headless): time GPU transfers and exit
+        bool benchmarkTransfers = false;
+        
+        // LUT export mode (headless): bake the adjustments into a .cube file
+        QString exportLut;
+        
+        // Statistics (headless, gpu backend): print histograms and clip
+        // counts of the developed image as JSON; output file then optional
+        QString stats;              // json
+        int statsBins = 256;        // 256 or 1024
+        bool statsProxy = false;    // Measure the preview proxy instead of full size
+        
+        // Render backend (headless): gpu, cpu
+        QString backend = "gpu";
+        
+        // RAW decode scale and demosaic algorithm (all modes)
+        RawProcessor::DecodeOptions decodeOptions;
+        
         // Adjustments
         float exposure = 0.0f;      // -3.0 to +3.0
         float contrast = 0.0f;      // -1.0 to +1.0
         float sharpness = 0.0f;     // 0.0 to 2.0
+        float sharpenRadius = 0.7f; // 0.5 to 4.0 pixels
         
         // Output format
         QString format = "tiff";    // tiff, jpeg, png
@@ -0,0 +1,58 @@
+#include "CubeLut.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <locale>
+
+namespace zraw {
+
+bool writeCubeLut(const std::string& path, const std::vector<float>& rgba, int size,
+                  const std::string& title, std::string* error) {
+    auto fail = [error](const std::string& message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+
+    if (size < 2 || size > 256) {
+        return fail("LUT size must be between 2 and 256");
+    }
+    size_t entries = static_cast<size_t>(size) * size * size;
+    if (rgba.size() != entries * 4) {
+        return fail("LUT data does not match size " + std::to_string(size));
+    }
+
+    std::ofstream file(path);
+    if (!file) {
+        return fail("Cannot open " + path + " for writing");
+    }
+
+    // QCoreApplication sets the C locale from the environment; .cube files
+    // always use '.' as the decimal separator
+    file.imbue(std::locale::classic());
+
+    if (!title.empty()) {
+        file << "TITLE \"" << title << "\"\n";
+    }
+    file << "LUT_3D_SIZE " << size << "\n";
+    file << "DOMAIN_MIN 0.0 0.0 0.0\n";
+    file << "DOMAIN_MAX 1.0 1.0 1.0\n\n";
+
+    // Most readers reject values outside the domain
+    file << std::fixed << std::setprecision(6);
+    for (size_t i = 0; i < entries; ++i) {
+        const float* entry = &rgba[i * 4];
+        file << std::clamp(entry[0], 0.0f, 1.0f) << ' '
+             << std::clamp(entry[1], 0.0f, 1.0f) << ' '
+             << std::clamp(entry[2], 0.0f, 1.0f) << '\n';
+    }
+
+    file.flush();
+    if (!file) {
+        return fail("Failed to write " + path);
+    }
+    return true;
+}
+
+} // namespace zraw
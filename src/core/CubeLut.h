@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace zraw {
+
+/**
+ * Writer for Adobe/Resolve .cube 3D LUTs
+ * @param rgba size^3 RGBA float entries, red varying fastest, then green,
+ *             then blue (the order of the file); alpha is ignored
+ * @param size Lattice points per axis (2-256)
+ * @param title Written as the TITLE line if not empty
+ * @param error Set to a description on failure
+ * @return false if the data doesn't match size or the file can't be written
+ */
+bool writeCubeLut(const std::string& path, const std::vector<float>& rgba, int size,
+                  const std::string& title, std::string* error = nullptr);
+
+} // namespace zraw
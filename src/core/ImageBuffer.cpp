@@ -1,48 +1,91 @@
 #include "ImageBuffer.h"
+#include "BufferPool.h"
 #include <algorithm>
 #include <cstring>
+#include <new>
 
 namespace zraw {
 
 ImageBuffer::ImageBuffer()
-    : m_width(0), m_height(0), m_channels(3) {
+    : m_width(0), m_height(0), m_channels(3), m_type(PixelType::UInt16), m_size(0),
+      m_data(nullptr, [](void*) {}) {
 }
 
-ImageBuffer::ImageBuffer(int width, int height, int channels)
-    : m_width(width), m_height(height), m_channels(channels) {
-    allocate(width, height, channels);
+ImageBuffer::ImageBuffer(int width, int height, int channels, PixelType type)
+    : ImageBuffer() {
+    allocate(width, height, channels, type);
 }
 
 ImageBuffer::~ImageBuffer() {
 }
 
-void ImageBuffer::allocate(int width, int height, int channels) {
+std::shared_ptr<ImageBuffer> ImageBuffer::adopt(void* data, int width, int height, int channels,
+                                                PixelType type, Deleter deleter) {
+    auto buffer = std::make_shared<ImageBuffer>();
+    buffer->m_width = width;
+    buffer->m_height = height;
+    buffer->m_channels = channels;
+    buffer->m_type = type;
+    buffer->m_size = static_cast<size_t>(width) * height * channels;
+    buffer->m_data = std::unique_ptr<void, Deleter>(data, std::move(deleter));
+    return buffer;
+}
+
+void ImageBuffer::allocate(int width, int height, int channels, PixelType type) {
     m_width = width;
     m_height = height;
     m_channels = channels;
-    m_data.resize(static_cast<size_t>(width) * height * channels);
+    m_type = type;
+    m_size = static_cast<size_t>(width) * height * channels;
+    
+    // Pooled, 64-byte aligned and left uninitialized - every producer
+    // overwrites all pixels
+    m_data.reset();
+    size_t bucketBytes = 0;
+    void* block = BufferPool::instance().acquire(byteSize(), bucketBytes);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    m_data = std::unique_ptr<void, Deleter>(
+        block, [bucketBytes](void* data) { BufferPool::instance().release(data, bucketBytes); });
+}
+
+ImageView ImageBuffer::view() {
+    return ImageView(static_cast<uint8_t*>(m_data.get()), m_width, m_height, m_channels,
+                     static_cast<size_t>(m_width) * m_channels * bytesPerSample(m_type), m_type);
+}
+
+ConstImageView ImageBuffer::view() const {
+    return ConstImageView(static_cast<const uint8_t*>(m_data.get()), m_width, m_height, m_channels,
+                          static_cast<size_t>(m_width) * m_channels * bytesPerSample(m_type), m_type);
 }
 
-void ImageBuffer::copyFrom(const uint16_t* src, size_t count) {
-    if (count > m_data.size()) {
-        count = m_data.size();
+void ImageBuffer::copyFrom(const void* src, size_t count) {
+    if (count > m_size) {
+        count = m_size;
     }
-    std::memcpy(m_data.data(), src, count * sizeof(uint16_t));
+    std::memcpy(m_data.get(), src, count * bytesPerSample(m_type));
 }
 
 std::vector<uint8_t> ImageBuffer::to8bit() const {
-    std::vector<uint8_t> result(m_data.size());
+    std::vector<uint8_t> result(m_size);
+    if (m_type != PixelType::UInt16) {
+        return result;
+    }
     
     // Convert 16-bit to 8-bit (simple downscaling)
-    for (size_t i = 0; i < m_data.size(); ++i) {
-        result[i] = static_cast<uint8_t>(m_data[i] >> 8);
+    const uint16_t* src = data();
+    for (size_t i = 0; i < m_size; ++i) {
+        result[i] = static_cast<uint8_t>(src[i] >> 8);
     }
     
     return result;
 }
 
 void ImageBuffer::clear() {
-    std::fill(m_data.begin(), m_data.end(), 0);
+    if (m_data) {
+        std::memset(m_data.get(), 0, byteSize());
+    }
 }
 
 } // namespace zraw
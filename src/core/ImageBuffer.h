@@ -1,38 +1,72 @@
 #pragma once
 
+#include "ImageView.h"
 #include <vector>
 #include <cstdint>
+#include <functional>
 #include <memory>
 
 namespace zraw {
 
 /**
  * Image buffer for storing raw and processed image data
- * Supports 16-bit per channel RGB data for high dynamic range
+ * Samples are 16-bit unsigned normalized (the decoder's output) or half/
+ * single float for scene-referred data that must keep values above 1.0
+ * Pixels live either in memory the buffer allocated itself or in memory
+ * adopted from a decoder (e.g. LibRaw's output image), released through the
+ * deleter supplied with it. Own allocations come from BufferPool: 64-byte
+ * aligned, reused across images and NOT zero-initialized (use clear()).
  */
 class ImageBuffer {
 public:
+    // Releases adopted pixel memory
+    using Deleter = std::function<void(void*)>;
+
     ImageBuffer();
-    ImageBuffer(int width, int height, int channels = 3);
+    ImageBuffer(int width, int height, int channels = 3, PixelType type = PixelType::UInt16);
     ~ImageBuffer();
 
+    ImageBuffer(const ImageBuffer&) = delete;
+    ImageBuffer& operator=(const ImageBuffer&) = delete;
+
+    /**
+     * Wrap existing pixel memory without copying
+     * @param deleter Called once with data when the buffer is released
+     */
+    static std::shared_ptr<ImageBuffer> adopt(void* data, int width, int height, int channels,
+                                              PixelType type, Deleter deleter);
+
     // Getters
     int width() const { return m_width; }
     int height() const { return m_height; }
     int channels() const { return m_channels; }
-    size_t size() const { return m_data.size(); }
+    PixelType pixelType() const { return m_type; }
+    size_t size() const { return m_size; }  // Samples, not bytes
+    size_t byteSize() const { return m_size * bytesPerSample(m_type); }
+    
+    // Data access as 16-bit samples (UInt16, or raw Float16 bits)
+    uint16_t* data() { return static_cast<uint16_t*>(m_data.get()); }
+    const uint16_t* data() const { return static_cast<const uint16_t*>(m_data.get()); }
+    
+    // Untyped access for any pixel type
+    void* bytes() { return m_data.get(); }
+    const void* bytes() const { return m_data.get(); }
     
-    // Data access
-    uint16_t* data() { return m_data.data(); }
-    const uint16_t* data() const { return m_data.data(); }
+    // Views of the whole image, a crop or a band of rows (no copies)
+    ImageView view();
+    ConstImageView view() const;
+    ImageView crop(int x, int y, int width, int height) { return view().crop(x, y, width, height); }
+    ConstImageView crop(int x, int y, int width, int height) const { return view().crop(x, y, width, height); }
+    ImageView rows(int y, int count) { return view().rows(y, count); }
+    ConstImageView rows(int y, int count) const { return view().rows(y, count); }
     
-    // Allocate buffer
-    void allocate(int width, int height, int channels = 3);
+    // Allocate buffer (contents undefined)
+    void allocate(int width, int height, int channels = 3, PixelType type = PixelType::UInt16);
     
-    // Copy data
-    void copyFrom(const uint16_t* src, size_t count);
+    // Copy data (count in samples of this buffer's type)
+    void copyFrom(const void* src, size_t count);
     
-    // Convert to 8-bit for display
+    // Convert UInt16 data to 8-bit for display
     std::vector<uint8_t> to8bit() const;
     
     // Clear buffer
@@ -42,7 +76,9 @@ private:
     int m_width;
     int m_height;
     int m_channels;
-    std::vector<uint16_t> m_data;
+    PixelType m_type;
+    size_t m_size;
+    std::unique_ptr<void, Deleter> m_data;
 };
 
 } // namespace zraw
@@ -19,13 +19,25 @@ bool ImageExporter::exportImage(const std::shared_ptr<ImageBuffer>& buffer,
         return false;
     }
     
+    return exportImage(buffer->view(), filepath, format, quality);
+}
+
+bool ImageExporter::exportImage(const ConstImageView& view,
+                                const QString& filepath,
+                                Format format,
+                                int quality) {
+    if (view.isEmpty() || view.channels() != 3 || view.pixelType() != PixelType::UInt16) {
+        std::cerr << "Invalid image view" << std::endl;
+        return false;
+    }
+    
     switch (format) {
         case Format::TIFF:
-            return exportTIFF(buffer, filepath);
+            return exportTIFF(view, filepath);
         case Format::JPEG:
-            return exportJPEG(buffer, filepath, quality);
+            return exportJPEG(view, filepath, quality);
         case Format::PNG:
-            return exportPNG(buffer, filepath);
+            return exportPNG(view, filepath);
     }
     
     return false;
@@ -61,7 +73,20 @@ ImageExporter::Format ImageExporter::formatFromString(const QString& formatStr)
     return Format::TIFF;
 }
 
-bool ImageExporter::exportTIFF(const std::shared_ptr<ImageBuffer>& buffer, const QString& filepath) {
+QString ImageExporter::extensionForFormat(Format format) {
+    switch (format) {
+        case Format::TIFF:
+            return "tiff";
+        case Format::JPEG:
+            return "jpg";
+        case Format::PNG:
+            return "png";
+    }
+    
+    return "tiff";
+}
+
+bool ImageExporter::exportTIFF(const ConstImageView& view, const QString& filepath) {
     // Use libtiff for proper 16-bit TIFF export
     TIFF* tif = TIFFOpen(filepath.toStdString().c_str(), "w");
     if (!tif) {
@@ -69,8 +94,8 @@ bool ImageExporter::exportTIFF(const std::shared_ptr<ImageBuffer>& buffer, const
         return false;
     }
     
-    uint32_t width = buffer->width();
-    uint32_t height = buffer->height();
+    uint32_t width = view.width();
+    uint32_t height = view.height();
     
     // Set TIFF tags
     TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, width);
@@ -83,11 +108,10 @@ bool ImageExporter::exportTIFF(const std::shared_ptr<ImageBuffer>& buffer, const
     TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_LZW);  // Lossless compression
     TIFFSetField(tif, TIFFTAG_SOFTWARE, "ZRaw Developer");
     
-    // Write image data row by row
-    const uint16_t* data = buffer->data();
-    
+    // Write image data row by row (libtiff does not modify the scanline)
     for (uint32_t row = 0; row < height; ++row) {
-        if (TIFFWriteScanline(tif, (void*)(data + row * width * 3), row, 0) < 0) {
+        void* scanline = const_cast<uint16_t*>(view.row<uint16_t>(row));
+        if (TIFFWriteScanline(tif, scanline, row, 0) < 0) {
             std::cerr << "Failed to write TIFF scanline " << row << std::endl;
             TIFFClose(tif);
             return false;
@@ -99,15 +123,11 @@ bool ImageExporter::exportTIFF(const std::shared_ptr<ImageBuffer>& buffer, const
     return true;
 }
 
-bool ImageExporter::exportJPEG(const std::shared_ptr<ImageBuffer>& buffer, 
+bool ImageExporter::exportJPEG(const ConstImageView& view, 
                                const QString& filepath, int quality) {
-    auto data8bit = convertTo8Bit(buffer);
+    QImage image = convertTo8Bit(view);
     
-    QImage image(data8bit.data(), buffer->width(), buffer->height(), 
-                 buffer->width() * 3, QImage::Format_RGB888);
-    QImage imageCopy = image.copy();  // Deep copy
-    
-    if (imageCopy.save(filepath, "JPEG", quality)) {
+    if (image.save(filepath, "JPEG", quality)) {
         std::cout << "Exported JPEG: " << filepath.toStdString() 
                   << " (quality: " << quality << ")" << std::endl;
         return true;
@@ -117,14 +137,10 @@ bool ImageExporter::exportJPEG(const std::shared_ptr<ImageBuffer>& buffer,
     return false;
 }
 
-bool ImageExporter::exportPNG(const std::shared_ptr<ImageBuffer>& buffer, const QString& filepath) {
-    auto data8bit = convertTo8Bit(buffer);
-    
-    QImage image(data8bit.data(), buffer->width(), buffer->height(), 
-                 buffer->width() * 3, QImage::Format_RGB888);
-    QImage imageCopy = image.copy();  // Deep copy
+bool ImageExporter::exportPNG(const ConstImageView& view, const QString& filepath) {
+    QImage image = convertTo8Bit(view);
     
-    if (imageCopy.save(filepath, "PNG")) {
+    if (image.save(filepath, "PNG")) {
         std::cout << "Exported PNG: " << filepath.toStdString() << std::endl;
         return true;
     }
@@ -133,19 +149,21 @@ bool ImageExporter::exportPNG(const std::shared_ptr<ImageBuffer>& buffer, const
     return false;
 }
 
-std::vector<uint8_t> ImageExporter::convertTo8Bit(const std::shared_ptr<ImageBuffer>& buffer) {
-    size_t pixelCount = buffer->width() * buffer->height() * 3;
-    std::vector<uint8_t> data8bit(pixelCount);
-    
-    const uint16_t* src = buffer->data();
-    uint8_t* dst = data8bit.data();
-    
-    // Convert 16-bit to 8-bit (simple right shift by 8)
-    for (size_t i = 0; i < pixelCount; ++i) {
-        dst[i] = src[i] >> 8;
+QImage ImageExporter::convertTo8Bit(const ConstImageView& view) {
+    QImage image(view.width(), view.height(), QImage::Format_RGB888);
+    size_t samplesPerRow = static_cast<size_t>(view.width()) * 3;
+    
+    for (int y = 0; y < view.height(); ++y) {
+        const uint16_t* src = view.row<uint16_t>(y);
+        uint8_t* dst = image.scanLine(y);
+        
+        // Convert 16-bit to 8-bit (simple right shift by 8)
+        for (size_t i = 0; i < samplesPerRow; ++i) {
+            dst[i] = src[i] >> 8;
+        }
     }
     
-    return data8bit;
+    return image;
 }
 
 } // namespace zraw
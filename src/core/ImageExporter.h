@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ImageBuffer.h"
+#include <QImage>
 #include <QString>
 #include <memory>
 
@@ -32,6 +33,15 @@ public:
                     Format format,
                     int quality = 95);
     
+    /**
+     * Export a view (whole image, crop or tile) without copying it first
+     * @param view 16-bit RGB pixels, any row stride
+     */
+    bool exportImage(const ConstImageView& view,
+                    const QString& filepath,
+                    Format format,
+                    int quality = 95);
+    
     /**
      * Get format from file extension
      */
@@ -41,14 +51,19 @@ public:
      * Get format from string
      */
     static Format formatFromString(const QString& formatStr);
+    
+    /**
+     * Get default file extension (without dot) for format
+     */
+    static QString extensionForFormat(Format format);
 
 private:
-    bool exportTIFF(const std::shared_ptr<ImageBuffer>& buffer, const QString& filepath);
-    bool exportJPEG(const std::shared_ptr<ImageBuffer>& buffer, const QString& filepath, int quality);
-    bool exportPNG(const std::shared_ptr<ImageBuffer>& buffer, const QString& filepath);
+    bool exportTIFF(const ConstImageView& view, const QString& filepath);
+    bool exportJPEG(const ConstImageView& view, const QString& filepath, int quality);
+    bool exportPNG(const ConstImageView& view, const QString& filepath);
     
-    // Convert 16-bit to 8-bit for JPEG/PNG
-    std::vector<uint8_t> convertTo8Bit(const std::shared_ptr<ImageBuffer>& buffer);
+    // Convert 16-bit to 8-bit for JPEG/PNG, straight into the QImage rows
+    QImage convertTo8Bit(const ConstImageView& view);
 };
 
 } // namespace zraw
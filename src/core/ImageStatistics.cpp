@@ -0,0 +1,52 @@
+#include "ImageStatistics.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace zraw {
+
+namespace {
+
+// JSON numbers are doubles, exact for counts below 2^53
+QJsonArray toArray(const std::vector<uint64_t>& counts) {
+    QJsonArray array;
+    for (uint64_t count : counts) {
+        array.append(static_cast<double>(count));
+    }
+    return array;
+}
+
+QJsonObject clipping(const uint64_t (&channels)[3], uint64_t any, uint64_t pixels) {
+    QJsonObject object;
+    object["red"] = static_cast<double>(channels[0]);
+    object["green"] = static_cast<double>(channels[1]);
+    object["blue"] = static_cast<double>(channels[2]);
+    object["any"] = static_cast<double>(any);
+    object["fraction"] = pixels ? static_cast<double>(any) / pixels : 0.0;
+    return object;
+}
+
+} // namespace
+
+std::string ImageStatistics::toJson() const {
+    QJsonObject histogram;
+    histogram["red"] = toArray(red);
+    histogram["green"] = toArray(green);
+    histogram["blue"] = toArray(blue);
+    histogram["luminance"] = toArray(luminance);
+
+    QJsonObject clipped;
+    clipped["highlights"] = clipping(highlightsClipped, highlightPixels, pixels());
+    clipped["shadows"] = clipping(shadowsClipped, shadowPixels, pixels());
+
+    QJsonObject root;
+    root["width"] = width;
+    root["height"] = height;
+    root["pixels"] = static_cast<double>(pixels());
+    root["bins"] = bins;
+    root["histogram"] = histogram;
+    root["clipping"] = clipped;
+    return QJsonDocument(root).toJson(QJsonDocument::Compact).toStdString();
+}
+
+} // namespace zraw
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace zraw {
+
+/**
+ * Histograms and clipping counts of a rendered image
+ * Values are output-encoded (0-1) and binned uniformly. A channel counts as
+ * clipped when it would round to 0 or 255 in 8-bit output.
+ */
+struct ImageStatistics {
+    int width = 0;   // Resolution measured: full image or preview proxy
+    int height = 0;
+    int bins = 0;
+    std::vector<uint64_t> red;
+    std::vector<uint64_t> green;
+    std::vector<uint64_t> blue;
+    std::vector<uint64_t> luminance;  // Rec. 2020 weights, as for sharpening
+
+    // Pixels clipped per channel (red, green, blue) and in any channel
+    uint64_t highlightsClipped[3] = {0, 0, 0};
+    uint64_t shadowsClipped[3] = {0, 0, 0};
+    uint64_t highlightPixels = 0;
+    uint64_t shadowPixels = 0;
+
+    uint64_t pixels() const { return static_cast<uint64_t>(width) * height; }
+
+    // Single-line JSON document
+    std::string toJson() const;
+};
+
+} // namespace zraw
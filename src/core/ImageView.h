@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace zraw {
+
+/**
+ * Sample format of image memory
+ */
+enum class PixelType {
+    UInt16,   // Unsigned normalized 16-bit
+    Float16,  // IEEE half float, scene-referred (may exceed 1.0)
+    Float32   // IEEE single float, scene-referred (may exceed 1.0)
+};
+
+inline size_t bytesPerSample(PixelType type) {
+    switch (type) {
+        case PixelType::UInt16:
+        case PixelType::Float16:
+            return 2;
+        case PixelType::Float32:
+            return 4;
+    }
+    return 0;
+}
+
+/**
+ * Non-owning, strided window onto image memory
+ * Pixels within a row are packed; rows are rowStride bytes apart, so a view
+ * can describe a whole buffer, a band of rows or a crop without copying.
+ * The memory must outlive the view. ImageView converts implicitly to the
+ * read-only ConstImageView.
+ */
+template <typename Byte>
+class BasicImageView {
+public:
+    BasicImageView() = default;
+
+    BasicImageView(Byte* data, int width, int height, int channels, size_t rowStride,
+                   PixelType type = PixelType::UInt16)
+        : m_data(data), m_width(width), m_height(height), m_channels(channels),
+          m_rowStride(rowStride), m_type(type) {}
+
+    // ImageView -> ConstImageView
+    template <typename Other,
+              typename = std::enable_if_t<std::is_convertible_v<Other*, Byte*>>>
+    BasicImageView(const BasicImageView<Other>& other)
+        : m_data(other.data()), m_width(other.width()), m_height(other.height()),
+          m_channels(other.channels()), m_rowStride(other.rowStride()), m_type(other.pixelType()) {}
+
+    Byte* data() const { return m_data; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int channels() const { return m_channels; }
+    size_t rowStride() const { return m_rowStride; }
+    PixelType pixelType() const { return m_type; }
+
+    size_t pixelBytes() const { return m_channels * bytesPerSample(m_type); }
+    size_t rowBytes() const { return m_width * pixelBytes(); }
+    bool isEmpty() const { return !m_data || m_width <= 0 || m_height <= 0; }
+    bool isContiguous() const { return m_rowStride == rowBytes(); }
+
+    // Start of row y, typed as the sample type T (uint16_t for UInt16 and
+    // Float16 bits, float for Float32)
+    template <typename T>
+    auto row(int y) const {
+        using Sample = std::conditional_t<std::is_const_v<Byte>, const T, T>;
+        return reinterpret_cast<Sample*>(m_data + static_cast<size_t>(y) * m_rowStride);
+    }
+
+    // Sub-rectangle, clamped to this view
+    BasicImageView crop(int x, int y, int width, int height) const {
+        int x0 = std::clamp(x, 0, m_width);
+        int y0 = std::clamp(y, 0, m_height);
+        int x1 = std::clamp(x + width, x0, m_width);
+        int y1 = std::clamp(y + height, y0, m_height);
+        return BasicImageView(m_data + static_cast<size_t>(y0) * m_rowStride + x0 * pixelBytes(),
+                              x1 - x0, y1 - y0, m_channels, m_rowStride, m_type);
+    }
+
+    // Band of full-width rows [y, y + count)
+    BasicImageView rows(int y, int count) const {
+        return crop(0, y, m_width, count);
+    }
+
+private:
+    Byte* m_data = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    int m_channels = 0;
+    size_t m_rowStride = 0;
+    PixelType m_type = PixelType::UInt16;
+};
+
+using ImageView = BasicImageView<uint8_t>;
+using ConstImageView = BasicImageView<const uint8_t>;
+
+} // namespace zraw
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace zraw {
+
+/**
+ * Number of worker threads to use when none is requested explicitly
+ */
+inline int defaultWorkerCount() {
+    unsigned int cores = std::thread::hardware_concurrency();
+    return cores == 0 ? 1 : static_cast<int>(cores);
+}
+
+/**
+ * Run fn(chunkBegin, chunkEnd) over [begin, end) split into chunks of `grain`
+ * Chunks are handed out dynamically so fast threads pick up more work; the
+ * calling thread takes part, so threadCount == 1 runs inline.
+ * @param threadCount 0 = one thread per core
+ */
+template<typename Fn>
+void parallelFor(int begin, int end, int grain, Fn&& fn, int threadCount = 0) {
+    if (end <= begin) {
+        return;
+    }
+    grain = std::max(grain, 1);
+
+    int chunks = (end - begin + grain - 1) / grain;
+    if (threadCount <= 0) {
+        threadCount = defaultWorkerCount();
+    }
+    threadCount = std::min(threadCount, chunks);
+
+    std::atomic<int> nextChunk(0);
+    auto worker = [&]() {
+        for (int chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+            int chunkBegin = begin + chunk * grain;
+            fn(chunkBegin, std::min(chunkBegin + grain, end));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (int i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace zraw
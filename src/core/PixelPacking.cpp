@@ -0,0 +1,88 @@
+#include "PixelPacking.h"
+#include "ParallelFor.h"
+#include <cstdint>
+
+namespace zraw {
+
+namespace {
+
+// Rows handed to a worker thread at a time (a few MB per band at 24 MP)
+constexpr int kPackRows = 64;
+
+// Opaque alpha as raw sample bits
+constexpr uint16_t kAlphaUInt16 = 0xffff;
+constexpr uint16_t kAlphaFloat16 = 0x3c00;      // 1.0h
+constexpr uint32_t kAlphaFloat32 = 0x3f800000;  // 1.0f
+
+bool sameShape(const ConstImageView& a, const ConstImageView& b) {
+    return !a.isEmpty() && a.width() == b.width() && a.height() == b.height() &&
+           a.pixelType() == b.pixelType();
+}
+
+// Samples are moved as raw bits: T is uint16_t for 16-bit types and
+// uint32_t for Float32, so no conversion happens on the way
+template <typename T>
+void padRows(const ConstImageView& rgb, const ImageView& rgba, T alpha, int first, int last) {
+    const int width = rgb.width();
+    for (int y = first; y < last; ++y) {
+        const T* __restrict in = rgb.row<T>(y);
+        T* __restrict out = rgba.row<T>(y);
+        for (int x = 0; x < width; ++x) {
+            out[4 * x + 0] = in[3 * x + 0];
+            out[4 * x + 1] = in[3 * x + 1];
+            out[4 * x + 2] = in[3 * x + 2];
+            out[4 * x + 3] = alpha;
+        }
+    }
+}
+
+template <typename T>
+void stripRows(const ConstImageView& rgba, const ImageView& rgb, int first, int last) {
+    const int width = rgba.width();
+    for (int y = first; y < last; ++y) {
+        const T* __restrict in = rgba.row<T>(y);
+        T* __restrict out = rgb.row<T>(y);
+        for (int x = 0; x < width; ++x) {
+            out[3 * x + 0] = in[4 * x + 0];
+            out[3 * x + 1] = in[4 * x + 1];
+            out[3 * x + 2] = in[4 * x + 2];
+        }
+    }
+}
+
+} // namespace
+
+bool padToRGBA(const ConstImageView& rgb, const ImageView& rgba, int threadCount) {
+    if (!sameShape(rgb, rgba) || rgb.channels() != 3 || rgba.channels() != 4) {
+        return false;
+    }
+
+    PixelType type = rgb.pixelType();
+    parallelFor(0, rgb.height(), kPackRows, [&](int firstRow, int lastRow) {
+        if (type == PixelType::Float32) {
+            padRows<uint32_t>(rgb, rgba, kAlphaFloat32, firstRow, lastRow);
+        } else {
+            uint16_t alpha = type == PixelType::Float16 ? kAlphaFloat16 : kAlphaUInt16;
+            padRows<uint16_t>(rgb, rgba, alpha, firstRow, lastRow);
+        }
+    }, threadCount);
+    return true;
+}
+
+bool stripAlpha(const ConstImageView& rgba, const ImageView& rgb, int threadCount) {
+    if (!sameShape(rgba, rgb) || rgba.channels() != 4 || rgb.channels() != 3) {
+        return false;
+    }
+
+    PixelType type = rgba.pixelType();
+    parallelFor(0, rgba.height(), kPackRows, [&](int firstRow, int lastRow) {
+        if (type == PixelType::Float32) {
+            stripRows<uint32_t>(rgba, rgb, firstRow, lastRow);
+        } else {
+            stripRows<uint16_t>(rgba, rgb, firstRow, lastRow);
+        }
+    }, threadCount);
+    return true;
+}
+
+} // namespace zraw
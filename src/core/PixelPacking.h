@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ImageView.h"
+
+namespace zraw {
+
+/**
+ * RGB <-> RGBA repacking for GPU transfers
+ * Drivers take 4-channel uploads and readbacks on their fast path but
+ * repack 3-channel ones on the CPU, single-threaded. These convert between
+ * the two layouts in parallel row bands; the per-row loops are plain
+ * shuffles that -O3 -march=native vectorizes. Both views must have the same
+ * size and pixel type.
+ * @param threadCount 0 = one thread per core
+ * @return false if the views don't match
+ */
+
+// Copy RGB pixels into RGBA with opaque alpha (1.0, or 65535 for UInt16)
+bool padToRGBA(const ConstImageView& rgb, const ImageView& rgba, int threadCount = 0);
+
+// Copy the RGB channels of RGBA pixels, dropping alpha
+bool stripAlpha(const ConstImageView& rgba, const ImageView& rgb, int threadCount = 0);
+
+} // namespace zraw
@@ -0,0 +1,152 @@
+#include "RawLoader.h"
+#include <cmath>
+#include <iostream>
+
+namespace zraw {
+
+// Share of the progress bar taken by the half-size pass
+static const float kHalfSizeProgress = 0.25f;
+
+RawLoader::RawLoader()
+    : m_shutdown(false),
+      m_cancelRequested(false) {
+    m_thread = std::thread(&RawLoader::workerLoop, this);
+}
+
+RawLoader::~RawLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+        m_pending.reset();
+        m_cancelRequested = true;
+    }
+    m_wakeUp.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void RawLoader::load(const std::string& filepath, const RawProcessor::DecodeOptions& options,
+                     ProgressCallback progress, PreviewCallback preview, CompletionCallback completion) {
+    std::optional<Request> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        dropped = std::move(m_pending);
+        m_pending = Request{filepath, options, std::move(progress), std::move(preview), std::move(completion)};
+        m_cancelRequested = true;
+    }
+    m_wakeUp.notify_one();
+    
+    // A request replaced before it started still gets its completion
+    if (dropped && dropped->completion) {
+        Result result;
+        result.filepath = dropped->filepath;
+        result.cancelled = true;
+        dropped->completion(result);
+    }
+}
+
+void RawLoader::cancel() {
+    std::optional<Request> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        dropped = std::move(m_pending);
+        m_pending.reset();
+        m_cancelRequested = true;
+    }
+    
+    if (dropped && dropped->completion) {
+        Result result;
+        result.filepath = dropped->filepath;
+        result.cancelled = true;
+        dropped->completion(result);
+    }
+}
+
+void RawLoader::deliverPreview(const Request& request, const Result& base, Stage stage,
+                               std::shared_ptr<ImageBuffer> image) {
+    if (!request.preview || !image) {
+        return;
+    }
+    Result preview = base;
+    preview.stage = stage;
+    preview.success = true;
+    preview.image = std::move(image);
+    request.preview(preview);
+}
+
+void RawLoader::workerLoop() {
+    // One LibRaw instance reused for every file
+    RawProcessor rawProcessor;
+
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeUp.wait(lock, [this] { return m_shutdown || m_pending.has_value(); });
+            if (m_shutdown) {
+                return;
+            }
+            request = std::move(*m_pending);
+            m_pending.reset();
+            m_cancelRequested = false;
+        }
+
+        // Forward progress in whole-percent steps; the half-size pass takes the
+        // first quarter of the bar. Any newer request cancels
+        bool refine = (request.options.scale == RawProcessor::DecodeScale::Full);
+        float progressBase = 0.0f;
+        float progressScale = refine ? kHalfSizeProgress : 1.0f;
+        int lastPercent = -1;
+        rawProcessor.setProgressCallback([&](float fraction) {
+            float overall = progressBase + fraction * progressScale;
+            int percent = static_cast<int>(std::lround(overall * 100.0f));
+            if (percent != lastPercent && request.progress) {
+                lastPercent = percent;
+                request.progress(overall);
+            }
+            return !m_cancelRequested.load();
+        });
+
+        Result result;
+        result.filepath = request.filepath;
+        if (rawProcessor.loadRaw(request.filepath)) {
+            result.cameraWBKelvin = rawProcessor.getCameraWBTemperature();
+
+            // Embedded preview first, then a half-size decode, each shown as
+            // soon as it is ready
+            if (auto embedded = rawProcessor.extractEmbeddedPreview()) {
+                deliverPreview(request, result, Stage::EmbeddedPreview, embedded);
+            }
+            if (refine) {
+                RawProcessor::DecodeOptions halfSize;
+                halfSize.scale = RawProcessor::DecodeScale::Half;
+                if (!m_cancelRequested && rawProcessor.processToRGB(halfSize)) {
+                    deliverPreview(request, result, Stage::HalfSize, rawProcessor.getImageBuffer());
+                }
+                progressBase = kHalfSizeProgress;
+                progressScale = 1.0f - kHalfSizeProgress;
+            }
+
+            if (!m_cancelRequested && rawProcessor.processToRGB(request.options)) {
+                result.stage = Stage::Full;
+                result.success = true;
+                result.image = rawProcessor.getImageBuffer();
+            }
+        }
+        if (!result.success) {
+            result.cancelled = m_cancelRequested || rawProcessor.wasCancelled();
+            result.error = result.cancelled ? "Cancelled" : rawProcessor.lastError();
+        }
+        rawProcessor.setProgressCallback(nullptr);
+
+        if (result.cancelled) {
+            std::cout << "Cancelled loading " << request.filepath << std::endl;
+        }
+        if (request.completion) {
+            request.completion(result);
+        }
+    }
+}
+
+} // namespace zraw
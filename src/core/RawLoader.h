@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ImageBuffer.h"
+#include "RawProcessor.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace zraw {
+
+/**
+ * Background RAW decoder for the interactive viewer
+ * Runs LibRaw open/unpack/demosaic on a worker thread with a warm LibRaw
+ * instance. Each load delivers progressively better images: the embedded
+ * camera preview, a half-size decode, then the full demosaic. Starting a new
+ * load cancels the one in flight; only the latest request is decoded.
+ * Callbacks are invoked on the worker thread.
+ */
+class RawLoader {
+public:
+    enum class Stage {
+        EmbeddedPreview,  // Camera JPEG, available within milliseconds
+        HalfSize,         // Half-resolution decode without demosaic
+        Full              // Final image at the requested decode scale
+    };
+
+    struct Result {
+        std::string filepath;
+        Stage stage = Stage::Full;
+        std::shared_ptr<ImageBuffer> image;
+        float cameraWBKelvin = 5500.0f;
+        bool success = false;
+        bool cancelled = false;
+        std::string error;
+    };
+
+    // Fraction in [0, 1], reported in whole percent steps
+    using ProgressCallback = std::function<void(float fraction)>;
+    // Intermediate images (embedded preview, half size); always successful
+    using PreviewCallback = std::function<void(const Result&)>;
+    using CompletionCallback = std::function<void(const Result&)>;
+
+    RawLoader();
+    ~RawLoader();
+
+    RawLoader(const RawLoader&) = delete;
+    RawLoader& operator=(const RawLoader&) = delete;
+
+    /**
+     * Decode a file in the background, cancelling any load in progress
+     * @param options Scale and demosaic of the final image; the half-size
+     *        intermediate is skipped unless decoding at full scale
+     * @param preview Invoked for each intermediate image before completion
+     * @param completion Always invoked once with the full image or the failure,
+     *        also for cancelled loads
+     */
+    void load(const std::string& filepath, const RawProcessor::DecodeOptions& options,
+              ProgressCallback progress, PreviewCallback preview, CompletionCallback completion);
+
+    /**
+     * Cancel the load in progress and drop any queued one
+     */
+    void cancel();
+
+private:
+    struct Request {
+        std::string filepath;
+        RawProcessor::DecodeOptions options;
+        ProgressCallback progress;
+        PreviewCallback preview;
+        CompletionCallback completion;
+    };
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::optional<Request> m_pending;
+    bool m_shutdown;
+    std::atomic<bool> m_cancelRequested;
+
+    void workerLoop();
+    void deliverPreview(const Request& request, const Result& base, Stage stage,
+                        std::shared_ptr<ImageBuffer> image);
+};
+
+} // namespace zraw
@@ -1,44 +1,204 @@
 #include "RawProcessor.h"
 #include <libraw/libraw.h>
+#include <QImage>
+#include <QTransform>
+#include <algorithm>
 #include <iostream>
-#include <cstring>
 
 namespace zraw {
 
+// LibRaw reports each processing stage as one bit of LibRaw_progress, in order
+static const int kProgressStages = 20;
+
+// LibRaw user_qual codes, indexed by RawProcessor::Demosaic (Auto excluded)
+static const int kDemosaicQuality[] = {
+    -1,  // Auto
+    0,   // Linear
+    1,   // VNG
+    2,   // PPG
+    3,   // AHD
+    4,   // DCB
+    11,  // DHT
+    12   // AAHD
+};
+
+static const char* const kDemosaicNames[] = {
+    "auto", "linear", "vng", "ppg", "ahd", "dcb", "dht", "aahd"
+};
+
+// Average 2x2 pixel blocks (odd trailing rows/columns are dropped)
+static std::shared_ptr<ImageBuffer> halveImage(const ImageBuffer& source) {
+    int width = source.width() / 2;
+    int height = source.height() / 2;
+    int channels = source.channels();
+    auto result = std::make_shared<ImageBuffer>(width, height, channels);
+    
+    size_t srcStride = static_cast<size_t>(source.width()) * channels;
+    for (int y = 0; y < height; ++y) {
+        const uint16_t* row0 = source.data() + (2 * y) * srcStride;
+        const uint16_t* row1 = row0 + srcStride;
+        uint16_t* dest = result->data() + static_cast<size_t>(y) * width * channels;
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < channels; ++c) {
+                size_t i = static_cast<size_t>(2 * x) * channels + c;
+                uint32_t sum = row0[i] + row0[i + channels] + row1[i] + row1[i + channels];
+                dest[x * channels + c] = static_cast<uint16_t>((sum + 2) / 4);
+            }
+        }
+    }
+    
+    return result;
+}
+
+bool RawProcessor::parseDecodeScale(const std::string& text, DecodeScale& scale) {
+    if (text == "1" || text == "full") {
+        scale = DecodeScale::Full;
+    } else if (text == "1/2" || text == "half") {
+        scale = DecodeScale::Half;
+    } else if (text == "1/4" || text == "quarter") {
+        scale = DecodeScale::Quarter;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool RawProcessor::parseDemosaic(const std::string& text, Demosaic& demosaic) {
+    for (size_t i = 0; i < sizeof(kDemosaicNames) / sizeof(kDemosaicNames[0]); ++i) {
+        if (text == kDemosaicNames[i]) {
+            demosaic = static_cast<Demosaic>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
 RawProcessor::RawProcessor()
     : m_libraw(std::make_unique<LibRaw>()),
-      m_buffer(std::make_shared<ImageBuffer>()) {
+      m_buffer(std::make_shared<ImageBuffer>()),
+      m_cancelled(false),
+      m_unpacked(false) {
+    m_libraw->set_progress_handler(
+        [](void* data, enum LibRaw_progress stage, int iteration, int expected) {
+            return progressHandler(data, static_cast<int>(stage), iteration, expected);
+        },
+        this);
 }
 
 RawProcessor::~RawProcessor() {
 }
 
+int RawProcessor::progressHandler(void* data, int stage, int iteration, int expected) {
+    auto* self = static_cast<RawProcessor*>(data);
+    if (!self->m_progressCallback) {
+        return 0;
+    }
+    
+    // Stage index from its bit, plus the fraction done within the stage
+    int index = 0;
+    while (index < kProgressStages && (stage >> (index + 1)) != 0) {
+        ++index;
+    }
+    float within = expected > 0 ? static_cast<float>(iteration) / expected : 0.0f;
+    float fraction = std::min(1.0f, (index + within) / kProgressStages);
+    
+    // Non-zero makes LibRaw abort with LIBRAW_CANCELLED_BY_CALLBACK
+    return self->m_progressCallback(fraction) ? 0 : 1;
+}
+
+bool RawProcessor::checkResult(int ret, const char* action) {
+    if (ret == LIBRAW_SUCCESS) {
+        return true;
+    }
+    m_cancelled = (ret == LIBRAW_CANCELLED_BY_CALLBACK);
+    setError(std::string(action) + ": " + libraw_strerror(ret));
+    return false;
+}
+
 bool RawProcessor::loadRaw(const std::string& filepath) {
+    m_cancelled = false;
+    m_unpacked = false;
+    
     // Open raw file
     int ret = m_libraw->open_file(filepath.c_str());
+    return checkResult(ret, "Failed to open file");
+}
+
+std::shared_ptr<ImageBuffer> RawProcessor::extractEmbeddedPreview() {
+    int ret = m_libraw->unpack_thumb();
     if (ret != LIBRAW_SUCCESS) {
-        setError(std::string("Failed to open file: ") + libraw_strerror(ret));
-        return false;
+        return nullptr;
     }
     
-    return true;
+    libraw_processed_image_t* thumb = m_libraw->dcraw_make_mem_thumb(&ret);
+    if (!thumb) {
+        return nullptr;
+    }
+    
+    QImage image;
+    if (thumb->type == LIBRAW_IMAGE_JPEG) {
+        image = QImage::fromData(thumb->data, static_cast<int>(thumb->data_size), "JPG");
+    } else if (thumb->type == LIBRAW_IMAGE_BITMAP && thumb->colors == 3 && thumb->bits == 8) {
+        image = QImage(thumb->data, thumb->width, thumb->height, thumb->width * 3,
+                       QImage::Format_RGB888).copy();
+    }
+    LibRaw::dcraw_clear_mem(thumb);
+    
+    if (image.isNull()) {
+        return nullptr;
+    }
+    
+    // dcraw_process() applies the camera orientation, the thumbnail does not
+    QTransform rotation;
+    switch (m_libraw->imgdata.sizes.flip) {
+        case 3: rotation.rotate(180); break;
+        case 5: rotation.rotate(-90); break;
+        case 6: rotation.rotate(90); break;
+        default: break;
+    }
+    if (!rotation.isIdentity()) {
+        image = image.transformed(rotation);
+    }
+    image = image.convertToFormat(QImage::Format_RGB888);
+    
+    auto buffer = std::make_shared<ImageBuffer>(image.width(), image.height(), 3);
+    uint16_t* dest = buffer->data();
+    for (int y = 0; y < image.height(); ++y) {
+        const uchar* src = image.constScanLine(y);
+        for (int x = 0; x < image.width() * 3; ++x) {
+            *dest++ = static_cast<uint16_t>(src[x]) * 257;  // 8-bit to full 16-bit range
+        }
+    }
+    
+    return buffer;
 }
 
 bool RawProcessor::processToRGB() {
+    return processToRGB(DecodeOptions());
+}
+
+bool RawProcessor::processToRGB(const DecodeOptions& options) {
     // Unpack raw data
-    int ret = m_libraw->unpack();
-    if (ret != LIBRAW_SUCCESS) {
-        setError(std::string("Failed to unpack: ") + libraw_strerror(ret));
-        return false;
+    if (!m_unpacked) {
+        int ret = m_libraw->unpack();
+        if (!checkResult(ret, "Failed to unpack")) {
+            return false;
+        }
+        m_unpacked = true;
     }
     
     // Configure processing parameters
     libraw_output_params_t& params = m_libraw->imgdata.params;
     
+    // Half size skips demosaicing entirely (previews, contact sheets)
+    params.half_size = (options.scale == DecodeScale::Full) ? 0 : 1;
+    
     // Detect X-Trans sensor (Fujifilm)
     bool isXTrans = (m_libraw->imgdata.idata.filters == 9);
     
-    if (isXTrans) {
+    if (options.demosaic != Demosaic::Auto) {
+        params.user_qual = kDemosaicQuality[static_cast<int>(options.demosaic)];
+    } else if (isXTrans) {
         // X-Trans sensors: Use 3-pass algorithm (best quality for X-Trans)
         // Options: 0=linear, 1=VNG, 2=PPG, 3=AHD, 4=DCB, 11=DHT, 12=AAHD
         params.user_qual = 11;  // DHT (11) or AAHD (12) work best for X-Trans
@@ -62,45 +222,47 @@ bool RawProcessor::processToRGB() {
     params.no_auto_bright = 1;
     
     // Process to RGB
-    ret = m_libraw->dcraw_process();
-    if (ret != LIBRAW_SUCCESS) {
-        setError(std::string("Failed to process: ") + libraw_strerror(ret));
+    int ret = m_libraw->dcraw_process();
+    if (!checkResult(ret, "Failed to process")) {
         return false;
     }
     
-    // Get processed image
+    // Get processed image - the only allocation of the output pixels
     libraw_processed_image_t* image = m_libraw->dcraw_make_mem_image(&ret);
     if (!image) {
         setError(std::string("Failed to create image: ") + libraw_strerror(ret));
         return false;
     }
     
-    // Copy to our buffer
     int width = image->width;
     int height = image->height;
     int channels = image->colors;
     
-    m_buffer->allocate(width, height, channels);
-    
-    uint16_t* dest = m_buffer->data();
-    
-    // Check if output is 8-bit or 16-bit
-    if (image->bits == 8) {
+    // Fresh buffer per decode so a previously returned image stays valid
+    // while this processor is reused for the next file
+    if (image->bits == 16) {
+        // Adopt LibRaw's allocation: the pixels follow the image header, so
+        // the buffer frees the whole image once the last reference is gone
+        m_buffer = ImageBuffer::adopt(
+            image->data, width, height, channels, PixelType::UInt16,
+            [image](void*) { LibRaw::dcraw_clear_mem(image); });
+    } else {
         // Convert 8-bit to 16-bit
+        m_buffer = std::make_shared<ImageBuffer>(width, height, channels);
+        uint16_t* dest = m_buffer->data();
         const uint8_t* src = image->data;
         size_t pixelCount = static_cast<size_t>(width) * height * channels;
         for (size_t i = 0; i < pixelCount; ++i) {
             dest[i] = static_cast<uint16_t>(src[i]) << 8;
         }
-    } else {
-        // Copy 16-bit directly
-        const uint16_t* src = reinterpret_cast<const uint16_t*>(image->data);
-        size_t pixelCount = static_cast<size_t>(width) * height * channels;
-        std::memcpy(dest, src, pixelCount * sizeof(uint16_t));
+        
+        // Free LibRaw image
+        LibRaw::dcraw_clear_mem(image);
     }
     
-    // Free LibRaw image
-    LibRaw::dcraw_clear_mem(image);
+    if (options.scale == DecodeScale::Quarter) {
+        m_buffer = halveImage(*m_buffer);
+    }
     
     return true;
 }
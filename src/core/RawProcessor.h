@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ImageBuffer.h"
+#include <functional>
 #include <string>
 #include <memory>
 
@@ -15,14 +16,58 @@ namespace zraw {
  */
 class RawProcessor {
 public:
+    // Receives overall progress in [0, 1]; return false to cancel the decode
+    using ProgressCallback = std::function<bool(float fraction)>;
+
+    // Output resolution of processToRGB()
+    enum class DecodeScale {
+        Full,     // Full-resolution demosaic
+        Half,     // One pixel per 2x2 sensor block (LibRaw half_size), no demosaic
+        Quarter   // Half size, then 2x2 box-averaged
+    };
+
+    // Demosaic algorithm for full-scale decodes (LibRaw user_qual)
+    enum class Demosaic {
+        Auto,     // AHD for Bayer, DHT for X-Trans
+        Linear,
+        VNG,
+        PPG,
+        AHD,
+        DCB,
+        DHT,
+        AAHD
+    };
+
+    struct DecodeOptions {
+        DecodeScale scale = DecodeScale::Full;
+        Demosaic demosaic = Demosaic::Auto;
+    };
+
+    // Parse "1", "1/2" or "1/4"
+    static bool parseDecodeScale(const std::string& text, DecodeScale& scale);
+    // Parse "auto", "linear", "vng", "ppg", "ahd", "dcb", "dht" or "aahd"
+    static bool parseDemosaic(const std::string& text, Demosaic& demosaic);
+
     RawProcessor();
     ~RawProcessor();
 
+    // Report progress of loadRaw()/processToRGB(); called on the decoding thread
+    void setProgressCallback(ProgressCallback callback) { m_progressCallback = std::move(callback); }
+    
+    // True if the last failure was a cancellation from the progress callback
+    bool wasCancelled() const { return m_cancelled; }
+
     // Load raw file
     bool loadRaw(const std::string& filepath);
     
-    // Process raw data to RGB
+    // Process raw data to RGB; may be called repeatedly after loadRaw(),
+    // e.g. a fast half-size decode followed by the full one
     bool processToRGB();
+    bool processToRGB(const DecodeOptions& options);
+    
+    // Decode the camera's embedded preview (usually a JPEG) after loadRaw()
+    // Returns nullptr if the file has none; rotated like processToRGB() output
+    std::shared_ptr<ImageBuffer> extractEmbeddedPreview();
     
     // Get processed image buffer
     std::shared_ptr<ImageBuffer> getImageBuffer() const { return m_buffer; }
@@ -45,8 +90,13 @@ private:
     std::unique_ptr<LibRaw> m_libraw;
     std::shared_ptr<ImageBuffer> m_buffer;
     std::string m_lastError;
+    ProgressCallback m_progressCallback;
+    bool m_cancelled;
+    bool m_unpacked;  // unpack() may only run once per open file
     
+    static int progressHandler(void* data, int stage, int iteration, int expected);
     void setError(const std::string& error);
+    bool checkResult(int ret, const char* action);
 };
 
 } // namespace zraw
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ImageBuffer.h"
+#include <memory>
+
+namespace zraw {
+
+/**
+ * Common interface of the develop pipelines (GPU and CPU)
+ * Setters take the same units as the adjustment sliders; process() renders
+ * the uploaded image with the current settings and downloadImage() returns
+ * the 16-bit RGB result.
+ */
+class RenderBackend {
+public:
+    virtual ~RenderBackend() = default;
+
+    // Initialize backend resources
+    virtual bool initialize() = 0;
+
+    // Set source image
+    virtual bool uploadImage(std::shared_ptr<ImageBuffer> buffer) = 0;
+
+    // Apply adjustments
+    virtual void setExposure(float exposure) = 0;
+    virtual void setContrast(float contrast) = 0;
+    virtual void setSharpness(float sharpness) = 0;
+    virtual void setSharpenRadius(float radius) = 0;  // Gaussian sigma, 0.5-4.0 px
+    virtual void setTemperature(float temperature) = 0;
+    virtual void setTint(float tint) = 0;
+    virtual void setHighlights(float highlights) = 0;
+    virtual void setShadows(float shadows) = 0;
+    virtual void setVibrance(float vibrance) = 0;
+    virtual void setSaturation(float saturation) = 0;
+    virtual void setHighlightContrast(float highlightContrast) = 0;
+    virtual void setMidtoneContrast(float midtoneContrast) = 0;
+    virtual void setShadowContrast(float shadowContrast) = 0;
+    virtual void setWhites(float whites) = 0;
+    virtual void setBlacks(float blacks) = 0;
+
+    // Output mode: 0=SDR, 1=HDR PQ, 2=HDR HLG, 3=Full ACES
+    virtual void setOutputMode(int mode) = 0;
+
+    // Before/After toggle
+    virtual void setBypassAdjustments(bool bypass) = 0;
+
+    // Process image with current settings
+    virtual bool process() = 0;
+
+    // Get processed image
+    virtual std::shared_ptr<ImageBuffer> downloadImage() = 0;
+
+    // Asynchronous readback (optional): beginDownload() queues a copy of the
+    // current render and returns without waiting for it; finishDownload()
+    // returns the oldest queued image, blocking only if it isn't ready yet.
+    // Backends without async transfers return false and callers fall back to
+    // downloadImage()
+    virtual bool beginDownload() { return false; }
+    virtual std::shared_ptr<ImageBuffer> finishDownload() { return nullptr; }
+
+    // Get image dimensions
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+};
+
+} // namespace zraw
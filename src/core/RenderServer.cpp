@@ -0,0 +1,304 @@
+#include "RenderServer.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace zraw {
+
+namespace {
+
+// How often the accept loop checks for a stop request
+constexpr int kPollIntervalMs = 250;
+
+// JSON field name -> adjustment member
+const std::pair<const char*, float XMPHandler::Adjustments::*> kAdjustmentFields[] = {
+    {"exposure", &XMPHandler::Adjustments::exposure},
+    {"contrast", &XMPHandler::Adjustments::contrast},
+    {"sharpness", &XMPHandler::Adjustments::sharpness},
+    {"temperature", &XMPHandler::Adjustments::temperature},
+    {"tint", &XMPHandler::Adjustments::tint},
+    {"highlights", &XMPHandler::Adjustments::highlights},
+    {"shadows", &XMPHandler::Adjustments::shadows},
+    {"vibrance", &XMPHandler::Adjustments::vibrance},
+    {"saturation", &XMPHandler::Adjustments::saturation},
+    {"highlightContrast", &XMPHandler::Adjustments::highlightContrast},
+    {"midtoneContrast", &XMPHandler::Adjustments::midtoneContrast},
+    {"shadowContrast", &XMPHandler::Adjustments::shadowContrast},
+};
+
+bool sendAll(int fd, const QByteArray& data) {
+    const char* ptr = data.constData();
+    size_t remaining = static_cast<size_t>(data.size());
+    while (remaining > 0) {
+        ssize_t sent = ::send(fd, ptr, remaining, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        ptr += sent;
+        remaining -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+QByteArray errorReply(QJsonObject reply, const QString& error) {
+    reply["status"] = "error";
+    reply["error"] = error;
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+} // namespace
+
+RenderServer::RenderServer(BatchProcessor& processor)
+    : m_processor(processor),
+      m_listenFd(-1),
+      m_stopRequested(false),
+      m_failed(false) {
+}
+
+RenderServer::~RenderServer() {
+    stop();
+    wait();
+}
+
+bool RenderServer::listen(const QString& socketPath) {
+    std::string path = socketPath.toStdString();
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        setError("Invalid socket path: " + path);
+        return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    // Only a socket (stale, left behind by a previous instance) is replaced;
+    // a mistyped path must not delete a regular file
+    struct stat info;
+    if (::lstat(path.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            setError(path + " exists and is not a socket");
+            return false;
+        }
+        ::unlink(path.c_str());
+    } else if (errno != ENOENT) {
+        setError("Cannot check socket path " + path + ": " + std::strerror(errno));
+        return false;
+    }
+
+    m_listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0) {
+        setError(std::string("Failed to create socket: ") + std::strerror(errno));
+        return false;
+    }
+
+    if (::bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(m_listenFd, SOMAXCONN) < 0) {
+        setError("Failed to listen on " + path + ": " + std::strerror(errno));
+        ::close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+
+    m_socketPath = socketPath;
+    m_acceptThread = std::thread(&RenderServer::acceptLoop, this);
+
+    std::cout << "Render server listening on " << path << std::endl;
+    return true;
+}
+
+void RenderServer::wait() {
+    if (m_acceptThread.joinable()) {
+        m_acceptThread.join();
+    }
+}
+
+void RenderServer::acceptLoop() {
+    while (!m_stopRequested) {
+        pollfd pfd{m_listenFd, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, kPollIntervalMs);
+        reapConnections(false);
+        if (ready < 0 && errno != EINTR) {
+            setError(std::string("Failed to poll the listening socket: ") + std::strerror(errno));
+            m_failed = true;
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        int clientFd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(m_connectionsMutex);
+        auto connection = std::make_unique<Connection>();
+        connection->fd = clientFd;
+        connection->thread = std::thread(&RenderServer::serveConnection, this, connection.get());
+        m_connections.push_back(std::move(connection));
+    }
+
+    std::cout << "Render server shutting down" << std::endl;
+
+    ::close(m_listenFd);
+    m_listenFd = -1;
+    ::unlink(m_socketPath.toStdString().c_str());
+
+    // In-flight jobs still complete because the render loop keeps running
+    // until the processor is told to finish below
+    reapConnections(true);
+    m_processor.finish();
+}
+
+void RenderServer::serveConnection(Connection* connection) {
+    QByteArray pending;
+    char chunk[4096];
+
+    while (true) {
+        ssize_t received = ::recv(connection->fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        pending.append(chunk, received);
+
+        // One request per line
+        int newline;
+        bool connected = true;
+        while (connected && (newline = pending.indexOf('\n')) >= 0) {
+            QByteArray line = pending.left(newline).trimmed();
+            pending.remove(0, newline + 1);
+            if (line.isEmpty()) {
+                continue;
+            }
+
+            QByteArray reply = handleRequest(line);
+            reply.append('\n');
+            connected = sendAll(connection->fd, reply);
+        }
+        if (!connected) {
+            break;
+        }
+    }
+
+    connection->finished = true;
+}
+
+QByteArray RenderServer::handleRequest(const QByteArray& line) {
+    QJsonObject reply;
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        return errorReply(reply, "Invalid JSON request: " + parseError.errorString());
+    }
+
+    QJsonObject request = document.object();
+    if (request.contains("id")) {
+        reply["id"] = request.value("id");
+    }
+
+    BatchProcessor::Job job;
+    job.inputFile = request.value("input").toString();
+    job.outputFile = request.value("output").toString();
+    if (job.inputFile.isEmpty() || job.outputFile.isEmpty()) {
+        return errorReply(reply, "Both \"input\" and \"output\" are required");
+    }
+
+    job.format = request.contains("format")
+        ? ImageExporter::formatFromString(request.value("format").toString())
+        : ImageExporter::formatFromExtension(job.outputFile);
+    job.quality = std::clamp(request.value("quality").toInt(95), 1, 100);
+
+    if (request.contains("decode_scale") &&
+        !RawProcessor::parseDecodeScale(request.value("decode_scale").toString().toStdString(),
+                                        job.decodeOptions.scale)) {
+        return errorReply(reply, "\"decode_scale\" must be \"1\", \"1/2\" or \"1/4\"");
+    }
+    if (request.contains("demosaic") &&
+        !RawProcessor::parseDemosaic(request.value("demosaic").toString().toLower().toStdString(),
+                                     job.decodeOptions.demosaic)) {
+        return errorReply(reply, "Unknown \"demosaic\" algorithm");
+    }
+
+    QJsonObject adjustments = request.value("adjustments").toObject();
+    for (const auto& field : kAdjustmentFields) {
+        job.adjustments.*field.second =
+            static_cast<float>(adjustments.value(field.first).toDouble(0.0));
+    }
+
+    // Hand the job to the warm pipeline and wait for it to come out the other end
+    auto promise = std::make_shared<std::promise<BatchProcessor::Result>>();
+    auto future = promise->get_future();
+    auto start = std::chrono::steady_clock::now();
+
+    if (!m_processor.submit(job, [promise](const BatchProcessor::Result& result) {
+            promise->set_value(result);
+        })) {
+        return errorReply(reply, "Server is shutting down");
+    }
+
+    BatchProcessor::Result result = future.get();
+    double totalMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+
+    QJsonObject timings;
+    timings["decode_ms"] = result.decodeMs;
+    timings["render_ms"] = result.renderMs;
+    timings["encode_ms"] = result.encodeMs;
+    timings["total_ms"] = totalMs;
+    reply["timings"] = timings;
+
+    if (!result.success) {
+        return errorReply(reply, QString::fromStdString(result.error));
+    }
+
+    reply["status"] = "ok";
+    reply["output"] = result.outputFile;
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+void RenderServer::reapConnections(bool closeAll) {
+    std::lock_guard<std::mutex> lock(m_connectionsMutex);
+
+    for (auto it = m_connections.begin(); it != m_connections.end();) {
+        Connection& connection = **it;
+        if (!closeAll && !connection.finished) {
+            ++it;
+            continue;
+        }
+
+        // Unblock a reader still waiting in recv()
+        if (!connection.finished) {
+            ::shutdown(connection.fd, SHUT_RDWR);
+        }
+        if (connection.thread.joinable()) {
+            connection.thread.join();
+        }
+        ::close(connection.fd);
+        it = m_connections.erase(it);
+    }
+}
+
+void RenderServer::setError(const std::string& error) {
+    m_lastError = error;
+    std::cerr << "RenderServer error: " << error << std::endl;
+}
+
+} // namespace zraw
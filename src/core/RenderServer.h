@@ -0,0 +1,83 @@
+#pragma once
+
+#include "BatchProcessor.h"
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace zraw {
+
+/**
+ * Render daemon listening on a Unix domain socket
+ * Clients send one JSON job per line and receive one JSON reply per line:
+ *
+ *   {"id": "42", "input": "/in/a.nef", "output": "/out/a.jpg",
+ *    "format": "jpeg", "quality": 90, "decode_scale": "1/2",
+ *    "adjustments": {"exposure": 0.3}}
+ *
+ *   {"id": "42", "status": "ok", "output": "/out/a.jpg",
+ *    "timings": {"decode_ms": ..., "render_ms": ..., "encode_ms": ..., "total_ms": ...}}
+ *
+ * Jobs are fed into a long-lived BatchProcessor, so the GL context, compiled
+ * shaders and the pool of LibRaw decoders stay warm between requests.
+ */
+class RenderServer {
+public:
+    explicit RenderServer(BatchProcessor& processor);
+    ~RenderServer();
+
+    /**
+     * Bind the socket and start accepting connections on a background thread
+     */
+    bool listen(const QString& socketPath);
+
+    /**
+     * Request shutdown; safe to call from a signal handler
+     * Open connections are closed and the processor is told to finish, which
+     * makes BatchProcessor::runRenderLoop() return.
+     */
+    void stop() { m_stopRequested = true; }
+
+    /**
+     * Wait for the accept thread and all connections to finish
+     */
+    void wait();
+
+    // True if the server stopped on an error rather than a stop() request
+    bool failed() const { return m_failed; }
+
+    // Error handling
+    std::string lastError() const { return m_lastError; }
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+
+    BatchProcessor& m_processor;
+    QString m_socketPath;
+    int m_listenFd;
+    std::atomic<bool> m_stopRequested;
+    std::atomic<bool> m_failed;
+    std::thread m_acceptThread;
+
+    std::mutex m_connectionsMutex;
+    std::list<std::unique_ptr<Connection>> m_connections;
+
+    std::string m_lastError;
+
+    void acceptLoop();
+    void serveConnection(Connection* connection);
+    QByteArray handleRequest(const QByteArray& line);
+    void reapConnections(bool closeAll);
+    void setError(const std::string& error);
+};
+
+} // namespace zraw
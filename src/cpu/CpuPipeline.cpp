@@ -0,0 +1,914 @@
+#include "CpuPipeline.h"
+#include "../core/ParallelFor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace zraw {
+
+// The develop math below mirrors fragmentShaderSource in GPUPipeline.cpp
+// stage by stage. Every stage is a loop over planar float rows without
+// data-dependent branches (selects only), so -O3 -march=native turns them
+// into AVX2/NEON code. Only gamut mapping, which needs the slow path for a
+// small fraction of pixels, has a scalar fallback.
+
+namespace {
+
+// Rows handed to a worker thread at a time
+constexpr int kBandRows = 16;
+
+// Sharpening radius as in GPUPipeline: Gaussian sigma in pixels, blurs
+// reaching three sigma
+constexpr float kDefaultSharpenRadius = 0.7f;
+constexpr float kMinSharpenRadius = 0.5f;
+constexpr float kMaxSharpenRadius = 4.0f;
+constexpr int kMaxSharpenTaps = 12;
+
+constexpr float kInv65535 = 1.0f / 65535.0f;
+
+// ============================================================================
+// MATH HELPERS
+// ============================================================================
+
+// log2 for x > 0: exponent from the float bits plus an atanh series on the
+// mantissa normalized to [sqrt(0.5), sqrt(2))
+inline float fastLog2(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    int exponent = static_cast<int>((bits >> 23) & 0xffu) - 127;
+    bits = (bits & 0x007fffffu) | 0x3f800000u;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+
+    bool high = m > 1.41421356f;
+    m = high ? m * 0.5f : m;
+    exponent += high ? 1 : 0;
+
+    float t = (m - 1.0f) / (m + 1.0f);
+    float t2 = t * t;
+    float ln = t * (2.0f + t2 * (2.0f / 3.0f + t2 * (2.0f / 5.0f + t2 * (2.0f / 7.0f + t2 * (2.0f / 9.0f)))));
+    return static_cast<float>(exponent) + ln * 1.44269504f;
+}
+
+// 2^x: integer part into the exponent bits, fraction via a polynomial
+// centred on 0.5
+inline float fastExp2(float x) {
+    x = std::min(std::max(x, -126.0f), 127.0f);
+
+    // x + 126 is never negative, so truncation is floor (and needs no select)
+    int whole = static_cast<int>(x + 126.0f) - 126;
+
+    float u = (x - static_cast<float>(whole) - 0.5f) * 0.693147181f;
+    float p = 1.0f + u * (1.0f + u * (1.0f / 2.0f + u * (1.0f / 6.0f + u * (1.0f / 24.0f +
+              u * (1.0f / 120.0f + u * (1.0f / 720.0f))))));
+
+    uint32_t bits = static_cast<uint32_t>(whole + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * 1.41421356f * scale;
+}
+
+// pow(x, y) for the x >= 0 range the shader relies on
+inline float fastPow(float x, float y) {
+    return x > 1e-30f ? fastExp2(y * fastLog2(x)) : 0.0f;
+}
+
+inline float fastExp(float x) {
+    return fastExp2(x * 1.44269504f);
+}
+
+inline float clamp01(float x) {
+    return std::min(std::max(x, 0.0f), 1.0f);
+}
+
+inline float smoothstep(float edge0, float edge1, float x) {
+    float t = clamp01((x - edge0) / (edge1 - edge0));
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// Rec.2020 luminance weights
+inline float luminance(float r, float g, float b) {
+    return r * 0.2627f + g * 0.6780f + b * 0.0593f;
+}
+
+// Per-channel shoulder above 1.0 (modified Reinhard, width 0.2)
+inline float shoulder(float x) {
+    float excess = std::max(x - 1.0f, 0.0f);
+    return x > 1.0f ? 1.0f + 0.2f * (excess / (excess + 0.2f)) : x;
+}
+
+// Narkowicz ACES fit
+inline float acesCurve(float x) {
+    return (x * (x + 0.0245786f) - 0.000090537f) / (x * (0.983729f * x + 0.4329510f) + 0.238081f);
+}
+
+// ============================================================================
+// COLOR SPACES
+// ============================================================================
+
+// 3x3 matrix in GLSL mat3() constructor order (column-major), so the
+// literals below can be copied from the shader unchanged
+struct Mat3 {
+    float m[9];
+};
+
+inline void apply(const Mat3& mat, float& r, float& g, float& b) {
+    const float* m = mat.m;
+    float x = m[0] * r + m[3] * g + m[6] * b;
+    float y = m[1] * r + m[4] * g + m[7] * b;
+    float z = m[2] * r + m[5] * g + m[8] * b;
+    r = x;
+    g = y;
+    b = z;
+}
+
+// a * b, i.e. b is applied first
+Mat3 multiply(const Mat3& a, const Mat3& b) {
+    Mat3 result{};
+    for (int col = 0; col < 3; ++col) {
+        for (int row = 0; row < 3; ++row) {
+            float sum = 0.0f;
+            for (int k = 0; k < 3; ++k) {
+                sum += a.m[k * 3 + row] * b.m[col * 3 + k];
+            }
+            result.m[col * 3 + row] = sum;
+        }
+    }
+    return result;
+}
+
+const Mat3 kRgbToXyz = {{
+    0.4124564f, 0.3575761f, 0.1804375f,
+    0.2126729f, 0.7151522f, 0.0721750f,
+    0.0193339f, 0.1191920f, 0.9503041f
+}};
+
+const Mat3 kXyzToRgb = {{
+     3.2404542f, -1.5371385f, -0.4985314f,
+    -0.9692660f,  1.8760108f,  0.0415560f,
+     0.0556434f, -0.2040259f,  1.0572252f
+}};
+
+const Mat3 kAp0ToAp1 = {{
+     1.4514393161f, -0.2365107469f, -0.2149285693f,
+    -0.0765537734f,  1.1762296998f, -0.0996759264f,
+     0.0083161484f, -0.0060324498f,  0.9977163014f
+}};
+
+const Mat3 kAp1ToAp0 = {{
+     0.6954522414f,  0.1406786965f,  0.1638690622f,
+     0.0447945634f,  0.8596711185f,  0.0955343182f,
+    -0.0055258826f,  0.0040252103f,  1.0015006723f
+}};
+
+const Mat3 kSrgbToAces = {{
+    0.4397010f, 0.3829780f, 0.1773350f,
+    0.0897923f, 0.8134230f, 0.0967616f,
+    0.0175440f, 0.1115440f, 0.8707040f
+}};
+
+const Mat3 kAp1ToSrgb = {{
+     1.7050509f, -0.6217921f, -0.0832588f,
+    -0.1302597f,  1.1408027f, -0.0105430f,
+    -0.0240033f, -0.1289687f,  1.1529720f
+}};
+
+// D65 reference white
+constexpr float kRefX = 0.95047f;
+constexpr float kRefY = 1.0f;
+constexpr float kRefZ = 1.08883f;
+
+inline float labF(float t) {
+    return t > 0.008856f ? fastPow(t, 1.0f / 3.0f) : 7.787f * t + 16.0f / 116.0f;
+}
+
+inline float labFInverse(float f) {
+    return f > 0.206897f ? f * f * f : (f - 16.0f / 116.0f) / 7.787f;
+}
+
+inline void rgbToLab(float r, float g, float b, float& L, float& A, float& B) {
+    apply(kRgbToXyz, r, g, b);
+    float fx = labF(r / kRefX);
+    float fy = labF(g / kRefY);
+    float fz = labF(b / kRefZ);
+    L = 116.0f * fy - 16.0f;
+    A = 500.0f * (fx - fy);
+    B = 200.0f * (fy - fz);
+}
+
+inline void labToRgb(float L, float A, float B, float& r, float& g, float& b) {
+    float fy = (L + 16.0f) / 116.0f;
+    float fx = A / 500.0f + fy;
+    float fz = fy - B / 200.0f;
+    r = labFInverse(fx) * kRefX;
+    g = labFInverse(fy) * kRefY;
+    b = labFInverse(fz) * kRefZ;
+    apply(kXyzToRgb, r, g, b);
+}
+
+// ============================================================================
+// GAMUT MAPPING (scalar, out-of-gamut pixels only)
+// ============================================================================
+
+inline bool isInGamut(float r, float g, float b) {
+    return r >= 0.0f && r <= 1.0f && g >= 0.0f && g <= 1.0f && b >= 0.0f && b <= 1.0f;
+}
+
+// adaptiveGamutMap() from the shader. Soft compression scales Lab a/b
+// directly, which equals scaling LCH chroma at constant hue.
+void gamutMapPixel(float& r, float& g, float& b) {
+    float maxOver = std::max(std::max(r - 1.0f, g - 1.0f), b - 1.0f);
+    float maxUnder = std::max(std::max(-r, -g), -b);
+    float dist = std::max(maxOver, maxUnder);
+
+    if (dist < 0.2f) {
+        float L, A, B;
+        rgbToLab(r, g, b, L, A, B);
+        float compression = 1.0f / (1.0f + dist * 2.0f);
+        labToRgb(L, A * compression, B * compression, r, g, b);
+        return;
+    }
+
+    // Perceptual mapping: compress chromaticity relative to luminance
+    float lum = luminance(r, g, b);
+    if (lum <= 0.0001f) {
+        r = g = b = 0.0f;
+        return;
+    }
+    float maxChroma = std::max(std::max(r, g), b) / lum;
+    if (maxChroma > 1.0f) {
+        float compressed = 1.0f + std::tanh((maxChroma - 1.0f) * 2.0f) * 0.2f;
+        float scale = compressed / maxChroma;
+        r *= scale;
+        g *= scale;
+        b *= scale;
+    }
+}
+
+// ============================================================================
+// DEVELOP PARAMETERS
+// ============================================================================
+
+struct ToneCurve {
+    bool active = false;
+    float control = 0.0f;
+    float center = 0.0f;
+    float width = 1.0f;
+};
+
+// Adjustments resolved into the constants each stage needs
+struct DevelopParams {
+    bool whiteBalance = false;
+    float gainR = 1.0f, gainG = 1.0f, gainB = 1.0f;
+
+    bool exposure = false;
+    float exposureGain = 1.0f;
+
+    // Whites, blacks, highlights, shadows (shader order)
+    ToneCurve curves[4];
+
+    bool contrast = false;
+    float contrastSlope = 1.0f;
+
+    bool zoneContrast = false;
+    float highlightContrast = 0.0f;
+    float midtoneContrast = 0.0f;
+    float shadowContrast = 0.0f;
+
+    bool color = false;
+    float saturationScale = 1.0f;
+    float vibrance = 0.0f;
+
+    int outputMode = 0;
+    Mat3 acesIn{};      // sRGB -> AP0 -> AP1
+    Mat3 acesOut{};     // AP1 -> AP0 -> AP1 -> sRGB
+
+    bool sharpen = false;
+    float sharpness = 0.0f;
+    int sharpenTaps = 0;                        // Blur taps on each side
+    float sharpenWeights[kMaxSharpenTaps + 1] = {};  // Normalized, centre first
+};
+
+// ============================================================================
+// ROW KERNELS
+// ============================================================================
+
+void loadRow(const uint16_t* __restrict src, float* __restrict r, float* __restrict g,
+             float* __restrict b, int n) {
+    for (int x = 0; x < n; ++x) {
+        r[x] = src[x * 3 + 0] * kInv65535;
+        g[x] = src[x * 3 + 1] * kInv65535;
+        b[x] = src[x * 3 + 2] * kInv65535;
+    }
+}
+
+void scaleRow(float* __restrict r, float* __restrict g, float* __restrict b, int n,
+              float gainR, float gainG, float gainB) {
+    for (int x = 0; x < n; ++x) {
+        r[x] *= gainR;
+        g[x] *= gainG;
+        b[x] *= gainB;
+    }
+}
+
+void exposureRow(float* __restrict r, float* __restrict g, float* __restrict b, int n, float gain) {
+    for (int x = 0; x < n; ++x) {
+        r[x] = shoulder(r[x] * gain);
+        g[x] = shoulder(g[x] * gain);
+        b[x] = shoulder(b[x] * gain);
+    }
+}
+
+// applyParametricToRGB(): curve on luminance, ratios preserved, then shoulder
+void toneCurveRow(float* __restrict r, float* __restrict g, float* __restrict b, int n,
+                  const ToneCurve& curve) {
+    const float control = curve.control;
+    const float center = curve.center;
+    const float invWidth = 1.0f / curve.width;
+
+    for (int x = 0; x < n; ++x) {
+        float lum = luminance(r[x], g[x], b[x]);
+        float safeLum = std::max(lum, 0.00001f);
+
+        float dist = (safeLum - center) * invWidth;
+        float weight = 1.0f / (1.0f + fastExp(-dist * 6.0f));
+        float gamma = 1.0f / (1.0f + control * weight);
+        float scale = fastPow(safeLum, gamma) / safeLum;
+
+        bool keep = lum < 0.00001f;
+        r[x] = keep ? r[x] : shoulder(r[x] * scale);
+        g[x] = keep ? g[x] : shoulder(g[x] * scale);
+        b[x] = keep ? b[x] : shoulder(b[x] * scale);
+    }
+}
+
+// Log-space contrast around 18% grey: (log2(c) / 10) scaled by slope, which
+// reduces to c^slope after the linearToLog/logToLinear round trip
+void contrastRow(float* __restrict r, float* __restrict g, float* __restrict b, int n, float slope) {
+    for (int x = 0; x < n; ++x) {
+        r[x] = fastExp2(fastLog2(std::max(r[x], 0.00001f)) * slope);
+        g[x] = fastExp2(fastLog2(std::max(g[x], 0.00001f)) * slope);
+        b[x] = fastExp2(fastLog2(std::max(b[x], 0.00001f)) * slope);
+    }
+}
+
+void zoneContrastRow(float* __restrict r, float* __restrict g, float* __restrict b, int n,
+                     const DevelopParams& params) {
+    const float hc = params.highlightContrast;
+    const float mc = params.midtoneContrast;
+    const float sc = params.shadowContrast;
+
+    for (int x = 0; x < n; ++x) {
+        float lum = luminance(r[x], g[x], b[x]);
+        float highlightMask = smoothstep(0.5f, 0.9f, lum);
+        float shadowMask = smoothstep(0.5f, 0.1f, lum);
+        float midtoneMask = 1.0f - highlightMask - shadowMask;
+        float slope = 1.0f + hc * highlightMask + mc * midtoneMask + sc * shadowMask;
+
+        r[x] = fastExp2(fastLog2(std::max(r[x], 0.00001f)) * slope);
+        g[x] = fastExp2(fastLog2(std::max(g[x], 0.00001f)) * slope);
+        b[x] = fastExp2(fastLog2(std::max(b[x], 0.00001f)) * slope);
+    }
+}
+
+// Saturation and vibrance on LCH chroma, done as a scale of Lab a/b so no
+// trigonometry is needed
+void colorRow(float* __restrict r, float* __restrict g, float* __restrict b, int n,
+              float saturationScale, float vibrance) {
+    for (int x = 0; x < n; ++x) {
+        float L, A, B;
+        rgbToLab(std::max(r[x], 0.0f), std::max(g[x], 0.0f), std::max(b[x], 0.0f), L, A, B);
+
+        float chroma = std::sqrt(A * A + B * B);
+        float newChroma = chroma * saturationScale;
+        newChroma += vibrance * (1.0f - clamp01(newChroma / 130.0f)) * 50.0f;
+        newChroma = std::max(newChroma, 0.0f);
+
+        // Achromatic pixels have hue 0 in the shader (atan(0, 0))
+        bool hasHue = chroma > 0.0f;
+        float newA = hasHue ? newChroma * (A / chroma) : newChroma;
+        float newB = hasHue ? newChroma * (B / chroma) : 0.0f;
+
+        labToRgb(L, newA, newB, r[x], g[x], b[x]);
+    }
+}
+
+// SDR: gentle luminance rolloff above 1.0
+void sdrRow(float* __restrict r, float* __restrict g, float* __restrict b, int n) {
+    for (int x = 0; x < n; ++x) {
+        float cr = std::max(r[x], 0.0f);
+        float cg = std::max(g[x], 0.0f);
+        float cb = std::max(b[x], 0.0f);
+        float lum = luminance(cr, cg, cb);
+        float over = std::max(lum - 1.0f, 0.0f);
+        float newLum = 1.0f + over / (1.0f + over);
+        float scale = lum > 1.0f ? newLum / lum : 1.0f;
+        r[x] = cr * scale;
+        g[x] = cg * scale;
+        b[x] = cb * scale;
+    }
+}
+
+// acesToneMap() used by the HDR outputs
+void acesToneMapRow(float* __restrict r, float* __restrict g, float* __restrict b, int n) {
+    for (int x = 0; x < n; ++x) {
+        float cr = std::max(r[x], 0.0f);
+        float cg = std::max(g[x], 0.0f);
+        float cb = std::max(b[x], 0.0f);
+        apply(kAp0ToAp1, cr, cg, cb);
+
+        float glow = std::max(0.0f, luminance(cr, cg, cb) - 0.5f) * 0.1f;
+        cr += glow;
+        cg += glow;
+        cb += glow;
+
+        float redMod = clamp01(cr / (cr + cg + cb + 0.001f));
+        cr *= 1.0f - 0.15f * redMod * 0.3f;
+
+        cr = acesCurve(cr);
+        cg = acesCurve(cg);
+        cb = acesCurve(cb);
+        apply(kAp1ToAp0, cr, cg, cb);
+
+        r[x] = cr;
+        g[x] = cg;
+        b[x] = cb;
+    }
+}
+
+// fullACESPipeline(): sRGB -> AP0 -> RRT -> ODT, with the back-to-back
+// matrices pre-multiplied
+void fullAcesRow(float* __restrict r, float* __restrict g, float* __restrict b, int n,
+                 const Mat3& acesIn, const Mat3& acesOut) {
+    for (int x = 0; x < n; ++x) {
+        float cr = std::max(r[x], 0.0f);
+        float cg = std::max(g[x], 0.0f);
+        float cb = std::max(b[x], 0.0f);
+        apply(acesIn, cr, cg, cb);
+
+        float glow = std::max(0.0f, luminance(cr, cg, cb) - 0.5f) * 0.12f;
+        cr += glow;
+        cg += glow;
+        cb += glow;
+
+        float redMod = smoothstep(0.5f, 1.0f, cr / (cr + cg + cb + 0.001f));
+        cr *= 1.0f - 0.18f * redMod * 0.4f;
+
+        // Pre-tone-mapping gamut compression
+        float lum = luminance(cr, cg, cb);
+        float maxChroma = std::max(std::max(cr, cg), cb) / std::max(lum, 0.0001f);
+        float compress = (1.0f + fastLog2(std::max(maxChroma, 1.0f)) * 0.693147181f * 0.3f) / maxChroma;
+        float scale = (lum > 0.0001f && maxChroma > 1.0f) ? compress : 1.0f;
+
+        cr = acesCurve(cr * scale);
+        cg = acesCurve(cg * scale);
+        cb = acesCurve(cb * scale);
+        apply(acesOut, cr, cg, cb);
+
+        r[x] = cr;
+        g[x] = cg;
+        b[x] = cb;
+    }
+}
+
+void gamutMapRow(float* __restrict r, float* __restrict g, float* __restrict b, int n) {
+    for (int x = 0; x < n; ++x) {
+        if (!isInGamut(r[x], g[x], b[x])) {
+            gamutMapPixel(r[x], g[x], b[x]);
+        }
+    }
+}
+
+// SMPTE ST 2084 on values scaled to 100 nits reference white
+void pqRow(float* __restrict r, float* __restrict g, float* __restrict b, int n) {
+    const float m1 = 0.1593017578125f;
+    const float m2 = 78.84375f;
+    const float c1 = 0.8359375f;
+    const float c2 = 18.8515625f;
+    const float c3 = 18.6875f;
+
+    auto encode = [=](float linear) {
+        float ym1 = fastPow(linear * 100.0f / 10000.0f, m1);
+        return fastPow((c1 + c2 * ym1) / (1.0f + c3 * ym1), m2);
+    };
+
+    for (int x = 0; x < n; ++x) {
+        r[x] = encode(r[x]);
+        g[x] = encode(g[x]);
+        b[x] = encode(b[x]);
+    }
+}
+
+// ITU-R BT.2100 HLG
+void hlgRow(float* __restrict r, float* __restrict g, float* __restrict b, int n) {
+    const float a = 0.17883277f;
+    const float bb = 0.28466892f;
+    const float c = 0.55991073f;
+
+    auto encode = [=](float linear) {
+        float low = std::sqrt(std::max(3.0f * linear, 0.0f));
+        float high = a * fastLog2(std::max(12.0f * linear - bb, 1e-30f)) * 0.693147181f + c;
+        return linear <= 1.0f / 12.0f ? low : high;
+    };
+
+    for (int x = 0; x < n; ++x) {
+        r[x] = encode(r[x]);
+        g[x] = encode(g[x]);
+        b[x] = encode(b[x]);
+    }
+}
+
+// Luminance and its square blurred along the row (the sharpening prepass
+// and horizontal blur); lum and square hold taps replicated pixels on each
+// side (clamp-to-edge)
+void sharpenMomentsRow(const float* __restrict r, const float* __restrict g, const float* __restrict b,
+                       int n, float* __restrict lum, float* __restrict square,
+                       float* __restrict mean, float* __restrict meanSquare,
+                       const float* __restrict weights, int taps) {
+    for (int x = 0; x < n; ++x) {
+        float l = luminance(r[x], g[x], b[x]);
+        lum[x + taps] = l;
+        square[x + taps] = l * l;
+    }
+    for (int i = 0; i < taps; ++i) {
+        lum[i] = lum[taps];
+        square[i] = square[taps];
+        lum[n + taps + i] = lum[n + taps - 1];
+        square[n + taps + i] = square[n + taps - 1];
+    }
+
+    for (int x = 0; x < n; ++x) {
+        mean[x] = weights[0] * lum[x + taps];
+        meanSquare[x] = weights[0] * square[x + taps];
+    }
+    for (int i = 1; i <= taps; ++i) {
+        const float weight = weights[i];
+        for (int x = 0; x < n; ++x) {
+            mean[x] += weight * (lum[x + taps + i] + lum[x + taps - i]);
+            meanSquare[x] += weight * (square[x + taps + i] + square[x + taps - i]);
+        }
+    }
+}
+
+// Luminance-only sharpening against the Gaussian mean and variance of the
+// adjusted luminance, as in the shader
+void sharpenRow(float* __restrict r, float* __restrict g, float* __restrict b, int n,
+                const float* __restrict mean, const float* __restrict meanSquare, float sharpness) {
+    for (int x = 0; x < n; ++x) {
+        float centerLum = luminance(r[x], g[x], b[x]);
+
+        float variance = std::max(meanSquare[x] - mean[x] * mean[x], 0.0f);
+        float detailMask = smoothstep(0.0001f, 0.001f, variance);
+        float detail = centerLum - mean[x];
+
+        float localContrast = std::sqrt(variance);
+        float adaptiveAmount = 0.5f + 0.5f * smoothstep(0.01f, 0.1f, localContrast);
+
+        float highlightProtection = 1.0f - smoothstep(0.9f, 1.0f, centerLum);
+        float shadowProtection = smoothstep(0.02f, 0.1f, centerLum);
+
+        float amount = sharpness * 0.5f * detailMask * adaptiveAmount *
+                       highlightProtection * shadowProtection;
+        float sharpenedLum = std::max(centerLum + detail * amount, 0.0f);
+        float scale = centerLum > 0.0001f ? sharpenedLum / centerLum : 1.0f;
+
+        r[x] *= scale;
+        g[x] *= scale;
+        b[x] *= scale;
+    }
+}
+
+// Clamp to [0, 1] (NaN -> 0) and quantize like the RGB16 framebuffer
+void storeRow(const float* __restrict r, const float* __restrict g, const float* __restrict b,
+              uint16_t* __restrict dst, int n) {
+    for (int x = 0; x < n; ++x) {
+        float cr = r[x] > 0.0f ? std::min(r[x], 1.0f) : 0.0f;
+        float cg = g[x] > 0.0f ? std::min(g[x], 1.0f) : 0.0f;
+        float cb = b[x] > 0.0f ? std::min(b[x], 1.0f) : 0.0f;
+        dst[x * 3 + 0] = static_cast<uint16_t>(static_cast<int>(cr * 65535.0f + 0.5f));
+        dst[x * 3 + 1] = static_cast<uint16_t>(static_cast<int>(cg * 65535.0f + 0.5f));
+        dst[x * 3 + 2] = static_cast<uint16_t>(static_cast<int>(cb * 65535.0f + 0.5f));
+    }
+}
+
+// Every stage up to sharpening for one row
+void developRow(const DevelopParams& params, const uint16_t* __restrict src,
+                float* __restrict r, float* __restrict g, float* __restrict b, int w) {
+    loadRow(src, r, g, b, w);
+
+    if (params.whiteBalance) {
+        scaleRow(r, g, b, w, params.gainR, params.gainG, params.gainB);
+    }
+    if (params.exposure) {
+        exposureRow(r, g, b, w, params.exposureGain);
+    }
+    for (const ToneCurve& curve : params.curves) {
+        if (curve.active) {
+            toneCurveRow(r, g, b, w, curve);
+        }
+    }
+    if (params.contrast) {
+        contrastRow(r, g, b, w, params.contrastSlope);
+    }
+    if (params.zoneContrast) {
+        zoneContrastRow(r, g, b, w, params);
+    }
+    if (params.color) {
+        colorRow(r, g, b, w, params.saturationScale, params.vibrance);
+    }
+
+    switch (params.outputMode) {
+    case 3:
+        fullAcesRow(r, g, b, w, params.acesIn, params.acesOut);
+        gamutMapRow(r, g, b, w);
+        break;
+    case 1:
+        acesToneMapRow(r, g, b, w);
+        gamutMapRow(r, g, b, w);
+        pqRow(r, g, b, w);
+        break;
+    case 2:
+        acesToneMapRow(r, g, b, w);
+        gamutMapRow(r, g, b, w);
+        hlgRow(r, g, b, w);
+        break;
+    default:
+        sdrRow(r, g, b, w);
+        gamutMapRow(r, g, b, w);
+        break;
+    }
+}
+
+// Run the whole develop chain over rows [firstRow, lastRow) of the views.
+// Sharpening measures the adjusted image around each pixel, so the chain
+// also runs over the blur's reach above and below the band
+void developRows(const DevelopParams& params, const ConstImageView& input, const ImageView& output,
+                 int firstRow, int lastRow) {
+    const int w = input.width();
+    const int h = input.height();
+
+    std::vector<float> rowR(w), rowG(w), rowB(w);
+    float* r = rowR.data();
+    float* g = rowG.data();
+    float* b = rowB.data();
+
+    if (!params.sharpen) {
+        for (int y = firstRow; y < lastRow; ++y) {
+            developRow(params, input.row<uint16_t>(y), r, g, b, w);
+            storeRow(r, g, b, output.row<uint16_t>(y), w);
+        }
+        return;
+    }
+
+    // Adjusted band rows, and the horizontally blurred moments of every row
+    // the vertical blur reaches (clamped to the image, like clamp-to-edge)
+    const int taps = params.sharpenTaps;
+    const int top = std::max(firstRow - taps, 0);
+    const int bottom = std::min(lastRow + taps, h);
+    const size_t stride = static_cast<size_t>(w);
+    std::vector<float> bandR(stride * (lastRow - firstRow));
+    std::vector<float> bandG(bandR.size()), bandB(bandR.size());
+    std::vector<float> means(stride * (bottom - top)), meanSquares(means.size());
+    std::vector<float> lum(stride + 2 * taps), square(lum.size());
+
+    for (int y = top; y < bottom; ++y) {
+        bool inBand = y >= firstRow && y < lastRow;
+        size_t band = static_cast<size_t>(y - firstRow) * stride;
+        float* pr = inBand ? bandR.data() + band : r;
+        float* pg = inBand ? bandG.data() + band : g;
+        float* pb = inBand ? bandB.data() + band : b;
+        developRow(params, input.row<uint16_t>(y), pr, pg, pb, w);
+        size_t row = static_cast<size_t>(y - top) * stride;
+        sharpenMomentsRow(pr, pg, pb, w, lum.data(), square.data(), means.data() + row,
+                          meanSquares.data() + row, params.sharpenWeights, taps);
+    }
+
+    std::vector<float> meanRow(w), meanSquareRow(w);
+    float* mean = meanRow.data();
+    float* meanSquare = meanSquareRow.data();
+    for (int y = firstRow; y < lastRow; ++y) {
+        std::fill(meanRow.begin(), meanRow.end(), 0.0f);
+        std::fill(meanSquareRow.begin(), meanSquareRow.end(), 0.0f);
+        for (int i = -taps; i <= taps; ++i) {
+            const float weight = params.sharpenWeights[std::abs(i)];
+            size_t row = static_cast<size_t>(std::min(std::max(y + i, 0), h - 1) - top) * stride;
+            const float* __restrict sourceMean = means.data() + row;
+            const float* __restrict sourceSquare = meanSquares.data() + row;
+            for (int x = 0; x < w; ++x) {
+                mean[x] += weight * sourceMean[x];
+                meanSquare[x] += weight * sourceSquare[x];
+            }
+        }
+
+        size_t band = static_cast<size_t>(y - firstRow) * stride;
+        float* pr = bandR.data() + band;
+        float* pg = bandG.data() + band;
+        float* pb = bandB.data() + band;
+        sharpenRow(pr, pg, pb, w, mean, meanSquare, params.sharpness);
+        storeRow(pr, pg, pb, output.row<uint16_t>(y), w);
+    }
+}
+
+} // namespace
+
+CpuPipeline::CpuPipeline(int threadCount)
+    : m_width(0), m_height(0),
+      m_threadCount(threadCount),
+      m_exposure(0.0f), m_contrast(0.0f), m_sharpness(0.0f),
+      m_sharpenRadius(kDefaultSharpenRadius),
+      m_temperature(0.0f), m_tint(0.0f),  // 0 = neutral (camera WB)
+      m_highlights(0.0f), m_shadows(0.0f),
+      m_vibrance(0.0f), m_saturation(0.0f),
+      m_highlightContrast(0.0f), m_midtoneContrast(0.0f), m_shadowContrast(0.0f),
+      m_whites(0.0f), m_blacks(0.0f),
+      m_outputMode(0),  // Default to SDR
+      m_bypassAdjustments(false) {
+}
+
+CpuPipeline::~CpuPipeline() = default;
+
+bool CpuPipeline::initialize() {
+    int threads = m_threadCount > 0 ? m_threadCount : defaultWorkerCount();
+    std::cout << "CPU pipeline: " << threads << " threads" << std::endl;
+    return true;
+}
+
+bool CpuPipeline::uploadImage(std::shared_ptr<ImageBuffer> buffer) {
+    if (!buffer || buffer->width() == 0 || buffer->height() == 0 || buffer->channels() != 3) {
+        setError("Invalid image buffer");
+        return false;
+    }
+    if (buffer->pixelType() != PixelType::UInt16) {
+        setError("CPU pipeline only supports 16-bit integer images");
+        return false;
+    }
+
+    m_input = std::move(buffer);
+    m_output.reset();
+    m_width = m_input->width();
+    m_height = m_input->height();
+    return true;
+}
+
+void CpuPipeline::setExposure(float exposure) {
+    m_exposure = exposure;
+}
+
+void CpuPipeline::setContrast(float contrast) {
+    m_contrast = contrast;
+}
+
+void CpuPipeline::setSharpness(float sharpness) {
+    m_sharpness = sharpness;
+}
+
+void CpuPipeline::setSharpenRadius(float radius) {
+    m_sharpenRadius = std::clamp(radius, kMinSharpenRadius, kMaxSharpenRadius);
+}
+
+void CpuPipeline::setTemperature(float temperature) {
+    m_temperature = temperature;
+}
+
+void CpuPipeline::setTint(float tint) {
+    m_tint = tint;
+}
+
+void CpuPipeline::setHighlights(float highlights) {
+    m_highlights = highlights;
+}
+
+void CpuPipeline::setShadows(float shadows) {
+    m_shadows = shadows;
+}
+
+void CpuPipeline::setVibrance(float vibrance) {
+    m_vibrance = vibrance;
+}
+
+void CpuPipeline::setSaturation(float saturation) {
+    m_saturation = saturation;
+}
+
+void CpuPipeline::setHighlightContrast(float highlightContrast) {
+    m_highlightContrast = highlightContrast;
+}
+
+void CpuPipeline::setMidtoneContrast(float midtoneContrast) {
+    m_midtoneContrast = midtoneContrast;
+}
+
+void CpuPipeline::setShadowContrast(float shadowContrast) {
+    m_shadowContrast = shadowContrast;
+}
+
+void CpuPipeline::setWhites(float whites) {
+    m_whites = whites;
+}
+
+void CpuPipeline::setBlacks(float blacks) {
+    m_blacks = blacks;
+}
+
+void CpuPipeline::setOutputMode(int mode) {
+    m_outputMode = mode;
+}
+
+void CpuPipeline::setBypassAdjustments(bool bypass) {
+    m_bypassAdjustments = bypass;
+}
+
+bool CpuPipeline::process() {
+    if (!m_input) {
+        setError("Pipeline not ready for processing");
+        return false;
+    }
+
+    // Same activation thresholds as the shader; bypass keeps only the output transform
+    auto value = [this](float v) { return m_bypassAdjustments ? 0.0f : v; };
+
+    DevelopParams params;
+
+    float temperature = value(m_temperature);
+    float tint = value(m_tint);
+    params.whiteBalance = std::fabs(temperature) > 0.1f || std::fabs(tint) > 0.1f;
+    params.gainR = 1.0f + temperature / 100.0f * 0.5f;
+    params.gainG = 1.0f + tint / 100.0f * 0.3f;
+    params.gainB = 1.0f - temperature / 100.0f * 0.5f;
+
+    float exposure = value(m_exposure);
+    params.exposure = std::fabs(exposure) > 0.01f;
+    params.exposureGain = std::exp2(exposure);
+
+    const float curveValues[4] = {value(m_whites), value(m_blacks), value(m_highlights), value(m_shadows)};
+    const float curveCenters[4] = {0.75f, 0.25f, 0.9f, 0.08f};
+    const float curveWidths[4] = {0.3f, 0.3f, 0.15f, 0.1f};
+    for (int i = 0; i < 4; ++i) {
+        params.curves[i].active = std::fabs(curveValues[i]) > 0.1f;
+        params.curves[i].control = curveValues[i] / 100.0f;
+        params.curves[i].center = curveCenters[i];
+        params.curves[i].width = curveWidths[i];
+    }
+
+    float contrast = value(m_contrast);
+    params.contrast = std::fabs(contrast) > 0.01f;
+    params.contrastSlope = 1.0f + contrast;
+
+    params.highlightContrast = value(m_highlightContrast) / 100.0f;
+    params.midtoneContrast = value(m_midtoneContrast) / 100.0f;
+    params.shadowContrast = value(m_shadowContrast) / 100.0f;
+    params.zoneContrast = std::fabs(params.highlightContrast) > 0.001f ||
+                          std::fabs(params.midtoneContrast) > 0.001f ||
+                          std::fabs(params.shadowContrast) > 0.001f;
+
+    float saturation = value(m_saturation);
+    float vibrance = value(m_vibrance);
+    params.color = std::fabs(saturation) > 0.1f || std::fabs(vibrance) > 0.1f;
+    params.saturationScale = std::fabs(saturation) > 0.1f ? 1.0f + saturation / 100.0f : 1.0f;
+    params.vibrance = std::fabs(vibrance) > 0.1f ? vibrance / 100.0f : 0.0f;
+
+    params.outputMode = m_outputMode;
+    params.acesIn = multiply(kAp0ToAp1, kSrgbToAces);
+    params.acesOut = multiply(kAp1ToSrgb, multiply(kAp0ToAp1, kAp1ToAp0));
+
+    params.sharpness = value(m_sharpness);
+    params.sharpen = params.sharpness > 0.001f;
+    params.sharpenTaps = std::clamp(static_cast<int>(std::ceil(3.0f * m_sharpenRadius)), 1, kMaxSharpenTaps);
+    float weightSum = 0.0f;
+    for (int i = 0; i <= params.sharpenTaps; ++i) {
+        params.sharpenWeights[i] = std::exp(-0.5f * i * i / (m_sharpenRadius * m_sharpenRadius));
+        weightSum += i == 0 ? params.sharpenWeights[i] : 2.0f * params.sharpenWeights[i];
+    }
+    for (int i = 0; i <= params.sharpenTaps; ++i) {
+        params.sharpenWeights[i] /= weightSum;
+    }
+
+    auto output = std::make_shared<ImageBuffer>(m_width, m_height, 3);
+    ConstImageView input = static_cast<const ImageBuffer&>(*m_input).view();
+    ImageView target = output->view();
+
+    // Sharpened bands also develop the blur's reach on both sides; taller
+    // bands keep that overlap to a quarter of the work
+    int bandRows = params.sharpen ? std::max(kBandRows, 8 * params.sharpenTaps) : kBandRows;
+    parallelFor(0, m_height, bandRows, [&](int firstRow, int lastRow) {
+        developRows(params, input, target, firstRow, lastRow);
+    }, m_threadCount);
+
+    m_output = output;
+    return true;
+}
+
+std::shared_ptr<ImageBuffer> CpuPipeline::downloadImage() {
+    return m_output;
+}
+
+void CpuPipeline::setError(const std::string& error) {
+    m_lastError = error;
+    std::cerr << "CpuPipeline error: " << error << std::endl;
+}
+
+} // namespace zraw
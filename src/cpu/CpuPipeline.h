@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../core/ImageBuffer.h"
+#include "../core/RenderBackend.h"
+#include <memory>
+#include <string>
+
+namespace zraw {
+
+/**
+ * CPU processing pipeline
+ * Software implementation of the GPUPipeline develop shader for machines
+ * without a usable GPU. The image is processed in bands of rows spread
+ * across all cores; inside a band each stage runs over planar float rows
+ * so the compiler can vectorize it for the host (AVX2, NEON, ...).
+ * Results match the GPU output to within a few 16-bit code values.
+ */
+class CpuPipeline : public RenderBackend {
+public:
+    /**
+     * @param threadCount Worker threads used by process() (0 = one per core)
+     */
+    explicit CpuPipeline(int threadCount = 0);
+    ~CpuPipeline() override;
+
+    // Initialize pipeline (nothing to set up, always succeeds)
+    bool initialize() override;
+
+    // Set source image (kept by reference, not copied)
+    bool uploadImage(std::shared_ptr<ImageBuffer> buffer) override;
+
+    // Apply adjustments
+    void setExposure(float exposure) override;
+    void setContrast(float contrast) override;
+    void setSharpness(float sharpness) override;
+    void setSharpenRadius(float radius) override;
+    void setTemperature(float temperature) override;
+    void setTint(float tint) override;
+    void setHighlights(float highlights) override;
+    void setShadows(float shadows) override;
+    void setVibrance(float vibrance) override;
+    void setSaturation(float saturation) override;
+    void setHighlightContrast(float highlightContrast) override;
+    void setMidtoneContrast(float midtoneContrast) override;
+    void setShadowContrast(float shadowContrast) override;
+    void setWhites(float whites) override;
+    void setBlacks(float blacks) override;
+
+    // Output mode: 0=SDR, 1=HDR PQ, 2=HDR HLG, 3=Full ACES
+    void setOutputMode(int mode) override;
+
+    // Before/After toggle
+    void setBypassAdjustments(bool bypass) override;
+
+    // Process image with current settings
+    bool process() override;
+
+    // Get processed image (a new buffer per process() call)
+    std::shared_ptr<ImageBuffer> downloadImage() override;
+
+    // Get image dimensions
+    int width() const override { return m_width; }
+    int height() const override { return m_height; }
+
+    // Error handling
+    std::string lastError() const { return m_lastError; }
+
+private:
+    std::shared_ptr<ImageBuffer> m_input;
+    std::shared_ptr<ImageBuffer> m_output;
+    int m_width;
+    int m_height;
+    int m_threadCount;
+
+    // Adjustment parameters
+    float m_exposure;
+    float m_contrast;
+    float m_sharpness;
+    float m_sharpenRadius;
+    float m_temperature;
+    float m_tint;
+    float m_highlights;
+    float m_shadows;
+    float m_vibrance;
+    float m_saturation;
+    float m_highlightContrast;
+    float m_midtoneContrast;
+    float m_shadowContrast;
+    float m_whites;
+    float m_blacks;
+    int m_outputMode;
+    bool m_bypassAdjustments;
+
+    std::string m_lastError;
+
+    void setError(const std::string& error);
+};
+
+} // namespace zraw
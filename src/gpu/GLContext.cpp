@@ -1,6 +1,18 @@
 #include "GLContext.h"
 #include <iostream>
 
+#ifdef ZRAW_HAVE_EGL
+#include <qpa/qplatformopenglcontext.h>
+#include <QtGui/private/qopenglcontext_p.h>
+// Keep eglplatform.h from pulling in Xlib, whose macros clash with Qt
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#include <dlfcn.h>
+#endif
+
 namespace zraw {
 
 GLContext::GLContext()
@@ -11,6 +23,11 @@ GLContext::~GLContext() {
 }
 
 bool GLContext::initialize() {
+    // Without a current context the functions would resolve to nothing
+    if (!QOpenGLContext::currentContext()) {
+        std::cerr << "No current OpenGL context" << std::endl;
+        return false;
+    }
     initializeOpenGLFunctions();
     
     m_initialized = true;
@@ -38,4 +55,208 @@ std::string GLContext::renderer() const {
     return rnd ? std::string(rnd) : "Unknown";
 }
 
+#ifdef ZRAW_HAVE_EGL
+namespace {
+
+bool hasExtension(const char* extensions, const char* name) {
+    if (!extensions) {
+        return false;
+    }
+    size_t length = std::strlen(name);
+    for (const char* p = extensions; (p = std::strstr(p, name)) != nullptr; p += length) {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Mesa's surfaceless platform (hardware drivers and llvmpipe) first, then
+// EGL devices (render nodes, drivers without the surfaceless platform)
+EGLDisplay openHeadlessDisplay() {
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (!getPlatformDisplay || !hasExtension(clientExtensions, "EGL_EXT_platform_base")) {
+        return EGL_NO_DISPLAY;
+    }
+
+    if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+            return display;
+        }
+    }
+
+    auto queryDevices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+    if (queryDevices && hasExtension(clientExtensions, "EGL_EXT_platform_device")) {
+        EGLDeviceEXT devices[16];
+        EGLint count = 0;
+        if (queryDevices(16, devices, &count)) {
+            for (EGLint i = 0; i < count; ++i) {
+                EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr);
+                if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+                    return display;
+                }
+            }
+        }
+    }
+    return EGL_NO_DISPLAY;
+}
+
+// Platform context for a surfaceless EGL context. Rendering only ever
+// targets framebuffer objects, so the surface passed by Qt is ignored.
+class SurfacelessEglContext : public QPlatformOpenGLContext {
+public:
+    SurfacelessEglContext(EGLDisplay display, EGLContext context, const QSurfaceFormat& format)
+        : m_display(display), m_context(context), m_format(format) {
+    }
+
+    ~SurfacelessEglContext() override {
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(m_display, m_context);
+        eglTerminate(m_display);
+    }
+
+    QSurfaceFormat format() const override { return m_format; }
+    bool isValid() const override { return m_context != EGL_NO_CONTEXT; }
+    void swapBuffers(QPlatformSurface*) override {}
+
+    bool makeCurrent(QPlatformSurface*) override {
+        return eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context) == EGL_TRUE;
+    }
+
+    void doneCurrent() override {
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    QFunctionPointer getProcAddress(const char* procName) override {
+        // Core entry points are only guaranteed with EGL_KHR_get_all_proc_addresses
+        QFunctionPointer function = reinterpret_cast<QFunctionPointer>(eglGetProcAddress(procName));
+        if (!function) {
+            function = reinterpret_cast<QFunctionPointer>(dlsym(RTLD_DEFAULT, procName));
+        }
+        return function;
+    }
+
+private:
+    EGLDisplay m_display;
+    EGLContext m_context;
+    QSurfaceFormat m_format;
+};
+
+} // namespace
+#endif
+
+HeadlessGLContext::HeadlessGLContext()
+    : m_surfaceless(false) {
+}
+
+HeadlessGLContext::~HeadlessGLContext() {
+    if (m_context) {
+        m_context->doneCurrent();
+    }
+}
+
+bool HeadlessGLContext::create() {
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    QSurfaceFormat::setDefaultFormat(format);
+
+    // QOpenGLContext::makeCurrent() needs a surface even when the context
+    // doesn't use it; without platform GL this is a hidden offscreen window
+    m_surface = std::make_unique<QOffscreenSurface>();
+    m_surface->setFormat(format);
+    m_surface->create();
+    if (!m_surface->isValid()) {
+        std::cerr << "Failed to create offscreen surface" << std::endl;
+        return false;
+    }
+
+    if (!createSurfaceless(format) && !createPlatform(format)) {
+        return false;
+    }
+
+    if (!m_context->makeCurrent(m_surface.get())) {
+        std::cerr << "Failed to make OpenGL context current" << std::endl;
+        return false;
+    }
+
+    std::cout << "OpenGL context created successfully ("
+              << (m_surfaceless ? "surfaceless EGL" : "platform offscreen") << ")" << std::endl;
+    return true;
+}
+
+bool HeadlessGLContext::createSurfaceless(const QSurfaceFormat& format) {
+#ifdef ZRAW_HAVE_EGL
+    EGLDisplay display = openHeadlessDisplay();
+    if (display == EGL_NO_DISPLAY) {
+        std::cout << "No headless EGL display, using the platform's OpenGL" << std::endl;
+        return false;
+    }
+
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!hasExtension(extensions, "EGL_KHR_surfaceless_context") ||
+        !hasExtension(extensions, "EGL_KHR_create_context") ||
+        !eglBindAPI(EGL_OPENGL_API)) {
+        std::cout << "EGL display can't create surfaceless desktop GL contexts, using the platform's OpenGL"
+                  << std::endl;
+        eglTerminate(display);
+        return false;
+    }
+
+    // Nothing is drawn to a surface, so any config will do
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    if (!hasExtension(extensions, "EGL_KHR_no_config_context")) {
+        const EGLint configAttribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLint count = 0;
+        if (!eglChooseConfig(display, configAttribs, &config, 1, &count) || count < 1) {
+            std::cerr << "No EGL config for desktop OpenGL" << std::endl;
+            eglTerminate(display);
+            return false;
+        }
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION_KHR, format.majorVersion(),
+        EGL_CONTEXT_MINOR_VERSION_KHR, format.minorVersion(),
+        EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create EGL context (error 0x" << std::hex << eglGetError() << std::dec
+                  << ")" << std::endl;
+        eglTerminate(display);
+        return false;
+    }
+
+    // The QOpenGLContext takes ownership of the platform context
+    m_context = std::make_unique<QOpenGLContext>();
+    QOpenGLContextPrivate::get(m_context.get())->adopt(new SurfacelessEglContext(display, context, format));
+    m_surfaceless = true;
+    return true;
+#else
+    (void)format;
+    return false;
+#endif
+}
+
+bool HeadlessGLContext::createPlatform(const QSurfaceFormat& format) {
+    m_context = std::make_unique<QOpenGLContext>();
+    m_context->setFormat(format);
+    if (!m_context->create()) {
+        std::cerr << "Failed to create OpenGL context" << std::endl;
+        m_context.reset();
+        return false;
+    }
+    m_surfaceless = false;
+    return true;
+}
+
 } // namespace zraw
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <QOffscreenSurface>
 #include <QOpenGLContext>
 #include <QOpenGLFunctions>
 #include <memory>
+#include <string>
 
 namespace zraw {
 
@@ -30,4 +32,32 @@ private:
     bool m_initialized;
 };
 
+/**
+ * Offscreen OpenGL 3.3 core context for headless rendering
+ * Prefers a surfaceless EGL context (Mesa's surfaceless platform, then the
+ * first EGL device such as a render node), which needs no X11 or Wayland
+ * server; it is adopted by a QOpenGLContext so the Qt GL wrappers work on
+ * it. Falls back to the Qt platform plugin's own offscreen context.
+ * Needs a QGuiApplication (the "offscreen" platform is enough).
+ */
+class HeadlessGLContext {
+public:
+    HeadlessGLContext();
+    ~HeadlessGLContext();
+
+    // Create the context and make it current on this thread
+    bool create();
+
+    // True if the context is a surfaceless EGL context
+    bool isSurfaceless() const { return m_surfaceless; }
+
+private:
+    std::unique_ptr<QOffscreenSurface> m_surface;
+    std::unique_ptr<QOpenGLContext> m_context;
+    bool m_surfaceless;
+
+    bool createSurfaceless(const QSurfaceFormat& format);
+    bool createPlatform(const QSurfaceFormat& format);
+};
+
 } // namespace zraw
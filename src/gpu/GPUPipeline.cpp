@@ -1,5 +1,12 @@
 #include "GPUPipeline.h"
+#include "../core/CubeLut.h"
+#include "../core/PixelPacking.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <string>
 
 namespace zraw {
 
@@ -11,37 +18,61 @@ layout (location = 1) in vec2 aTexCoord;
 
 out vec2 TexCoord;
 
+// Part of the input texture the quad covers (tiled proxy downsampling)
+uniform vec2 texCoordOffset = vec2(0.0);
+uniform vec2 texCoordScale = vec2(1.0);
+
 void main() {
     gl_Position = vec4(aPos, 0.0, 1.0);
-    TexCoord = aTexCoord;
+    TexCoord = texCoordOffset + aTexCoord * texCoordScale;
 }
 )";
 
 // Fragment shader with color-science-correct adjustments
+// Compiled per variant: GPUPipeline inserts USE_* defines for the stages
+// whose adjustment is non-zero and OUTPUT_MODE after the #version line, so
+// each program is straight-line code for exactly the stages in use.
+// Each develop pass runs a subset of the stages; only the last one clamps.
+// BAKE_LUT renders the color chain into a 3D LUT, USE_LUT applies it
 static const char* fragmentShaderSource = R"(
 #version 330 core
+#ifndef OUTPUT_MODE
+#define OUTPUT_MODE 0
+#endif
 in vec2 TexCoord;
 out vec4 FragColor;
 
 uniform sampler2D inputTexture;
-uniform float exposure;
-uniform float contrast;
-uniform float sharpness;
-uniform float temperature;
-uniform float tint;
-uniform float highlights;
-uniform float shadows;
-uniform float vibrance;
-uniform float saturation;
-uniform float highlightContrast;
-uniform float midtoneContrast;
-uniform float shadowContrast;
-uniform float whites;
-uniform float blacks;
-uniform vec2 texelSize;
-
-// Output mode: 0=SDR (default), 1=HDR PQ, 2=HDR HLG, 3=Full ACES
-uniform int outputMode;
+
+// Adjustment parameters, uploaded once per change; mirrors
+// GPUPipeline::DevelopParams (std140)
+layout(std140) uniform DevelopParams {
+    float exposure;
+    float contrast;
+    float sharpness;
+    float temperature;
+    float tint;
+    float highlights;
+    float shadows;
+    float vibrance;
+    float saturation;
+    float highlightContrast;
+    float midtoneContrast;
+    float shadowContrast;
+    float whites;
+    float blacks;
+    
+    // Output mode: 0=SDR (default), 1=HDR PQ, 2=HDR HLG, 3=Full ACES
+    int outputMode;
+};
+
+// Gaussian-weighted local mean of luminance and of its square (USE_SHARPENING)
+uniform sampler2D sharpenTexture;
+
+// 3D LUT of steps 2-8 (USE_LUT) and the slice being baked (BAKE_LUT)
+uniform sampler3D colorLut;
+uniform int lutSize;
+uniform int lutSlice;
 
 // ============================================================================
 // COLOR SCIENCE FUNCTIONS
@@ -642,25 +673,25 @@ vec3 fullACESPipeline(vec3 color) {
     return color;
 }
 
-void main() {
-    // ========================================================================
-    // PROPER COLOR SCIENCE PIPELINE ORDER
-    // ========================================================================
-    
-    // 1. Sample input (linear RGB from RAW processing)
-    vec3 color = texture(inputTexture, TexCoord).rgb;
-    
+// ============================================================================
+// PROPER COLOR SCIENCE PIPELINE ORDER
+// ============================================================================
+
+// Steps 2-8 are a pure function of the pixel's color; with USE_LUT they are
+// baked into colorLut (BAKE_LUT variant) and replaced by one lookup
+vec3 developColor(vec3 color) {
     // 2. White Balance FIRST (in linear space, before exposure)
     //    Camera WB already applied, this is for fine-tuning
     //    Temperature is relative (-100 to +100), 0 = neutral
-    if (abs(temperature) > 0.1 || abs(tint) > 0.1) {
-        color = applyWhiteBalance(color, temperature, tint);
-    }
+#ifdef USE_WHITE_BALANCE
+    color = applyWhiteBalance(color, temperature, tint);
+#endif
     
     // 3. Exposure with per-channel highlight compression
     //    Apply exposure, then compress each channel independently
     //    This prevents color shifts from differential clipping
-    if (abs(exposure) > 0.01) {
+#ifdef USE_EXPOSURE
+    {
         // Apply exposure
         color *= pow(2.0, exposure);
         
@@ -679,48 +710,60 @@ void main() {
             }
         }
     }
+#endif
     
     // 3.5. Whites and Blacks adjustment (parametric curve)
     //      Whites: adjusts the upper tonal range with smooth curve
     //      Blacks: adjusts the lower tonal range with smooth curve
-    if (abs(whites) > 0.1) {
+#ifdef USE_WHITES
+    {
         // Whites: parametric curve centered on bright tones
         float control = whites / 100.0;
         color = applyParametricToRGB(color, control, 0.75, 0.3);
     }
+#endif
     
-    if (abs(blacks) > 0.1) {
+#ifdef USE_BLACKS
+    {
         // Blacks: parametric curve centered on dark tones
         float control = blacks / 100.0;
         color = applyParametricToRGB(color, control, 0.25, 0.3);
     }
+#endif
     
     // 4. Highlights and Shadows Recovery (parametric curve)
     //      Highlights: targets very bright areas with narrow curve
     //      Shadows: targets very dark areas with narrow curve
-    if (abs(highlights) > 0.1) {
+#ifdef USE_HIGHLIGHTS
+    {
         // Highlights: narrow parametric curve centered on bright areas
         float control = highlights / 100.0;
         color = applyParametricToRGB(color, control, 0.9, 0.15);
     }
+#endif
     
-    if (abs(shadows) > 0.1) {
+#ifdef USE_SHADOWS
+    {
         // Shadows: very narrow parametric curve centered on dark areas
         // Use tighter width to only affect true shadows
         float control = shadows / 100.0;
         color = applyParametricToRGB(color, control, 0.08, 0.1);
     }
+#endif
     
     // 5. Global Contrast (in LOG space for perceptual uniformity)
-    if (abs(contrast) > 0.01) {
+#ifdef USE_CONTRAST
+    {
         vec3 logColor = linearToLog(color);
         // Apply contrast around middle gray (0.5 in log space = 18% gray)
         logColor = (logColor - 0.5) * (1.0 + contrast) + 0.5;
         color = logToLinear(logColor);
     }
+#endif
     
     // 6. Local Contrast / Tone-specific contrast (in log space)
-    if (abs(highlightContrast) > 0.1 || abs(midtoneContrast) > 0.1 || abs(shadowContrast) > 0.1) {
+#ifdef USE_TONE_CONTRAST
+    {
         float lum = luminance(color);
         
         // Better zone separation using smooth transitions
@@ -738,25 +781,29 @@ void main() {
         logColor = (logColor - 0.5) * (1.0 + localContrast) + 0.5;
         color = logToLinear(logColor);
     }
+#endif
     
     // 7. Saturation and Vibrance (in LCH space - perceptually uniform, no hue shifts)
-    if (abs(saturation) > 0.1 || abs(vibrance) > 0.1) {
+#if defined(USE_SATURATION) || defined(USE_VIBRANCE)
+    {
         // Convert to LCH (Lightness, Chroma, Hue)
         vec3 lch = rgbToLCH(max(color, 0.0));
         
         // Saturation: adjust chroma directly
-        if (abs(saturation) > 0.1) {
-            lch.y *= 1.0 + (saturation / 100.0);
-        }
+#ifdef USE_SATURATION
+        lch.y *= 1.0 + (saturation / 100.0);
+#endif
         
         // Vibrance: non-linear chroma boost (affects low-chroma colors more)
-        if (abs(vibrance) > 0.1) {
+#ifdef USE_VIBRANCE
+        {
             float vibranceFactor = vibrance / 100.0;
             // Normalize chroma to 0-1 range (typical max chroma ~130)
             float chromaNorm = clamp(lch.y / 130.0, 0.0, 1.0);
             float vibranceMask = 1.0 - chromaNorm; // Boost muted colors more
             lch.y += vibranceFactor * vibranceMask * 50.0;
         }
+#endif
         
         // Clamp chroma to reasonable range
         lch.y = max(lch.y, 0.0);
@@ -764,28 +811,34 @@ void main() {
         // Convert back to RGB
         color = lchToRGB(lch);
     }
+#endif
     
     // 8. Output Transform (tone mapping + color space conversion)
     //    Apply FIRST to get display-ready image, then sharpen
     
-    if (outputMode == 3) {
+#ifdef USE_OUTPUT_TRANSFORM
+#if OUTPUT_MODE == 3
+    {
         // Full ACES workflow (AP0 → RRT → ODT → sRGB)
         color = fullACESPipeline(max(color, 0.0));
         color = adaptiveGamutMap(color);
-        
-    } else if (outputMode == 1) {
+    }
+#elif OUTPUT_MODE == 1
+    {
         // HDR PQ (Perceptual Quantizer) for HDR10/Dolby Vision
         color = acesToneMap(max(color, 0.0));
         color = adaptiveGamutMap(color);
         color = linearToPQ(color * 100.0);
-        
-    } else if (outputMode == 2) {
+    }
+#elif OUTPUT_MODE == 2
+    {
         // HDR HLG (Hybrid Log-Gamma) for broadcast
         color = acesToneMap(max(color, 0.0));
         color = adaptiveGamutMap(color);
         color = linearToHLG(color);
-        
-    } else {
+    }
+#else
+    {
         // Default: SDR output with gentle tone curve
         // Simple shoulder to prevent clipping, but much less aggressive than ACES
         color = max(color, 0.0);
@@ -800,49 +853,50 @@ void main() {
         
         color = adaptiveGamutMap(color);
     }
+#endif
+#endif
+    
+    return color;
+}
+
+void main() {
+#ifdef BAKE_LUT
+    // Lattice point of the slice being rendered: red along x, green along y
+    vec3 lattice = vec3(gl_FragCoord.xy - 0.5, float(lutSlice)) / float(lutSize - 1);
+    FragColor = vec4(developColor(lattice), 1.0);
+#else
+    // 1. Sample input (linear RGB from RAW processing)
+    vec3 color = texture(inputTexture, TexCoord).rgb;
     
-    // 9. RAW Sharpening (Deconvolution-based, halo-free)
-    //    Uses high-frequency enhancement in luminance only
-    if (sharpness > 0.001) {
-        // Convert to luminance for sharpening
+#ifdef USE_LUT
+    // 2-8. Trilinear lookup between lattice points (texel centers)
+    float lutScale = float(lutSize - 1) / float(lutSize);
+    color = texture(colorLut, color * lutScale + 0.5 / float(lutSize)).rgb;
+#else
+    color = developColor(color);
+#endif
+    
+    // 9. RAW Sharpening (unsharp mask, halo-free)
+    //    Uses high-frequency enhancement in luminance only. The blurred
+    //    luminance and its local variance come from separable blur passes
+    //    over the adjusted image, so the cost doesn't grow with the radius
+#ifdef USE_SHARPENING
+    {
         float centerLum = luminance(color);
+        vec2 moments = texture(sharpenTexture, TexCoord).rg;
+        float blurred = moments.x;
         
-        // Sample 3x3 neighborhood in luminance
-        float l00 = luminance(texture(inputTexture, TexCoord + vec2(-1, -1) * texelSize).rgb);
-        float l01 = luminance(texture(inputTexture, TexCoord + vec2( 0, -1) * texelSize).rgb);
-        float l02 = luminance(texture(inputTexture, TexCoord + vec2( 1, -1) * texelSize).rgb);
-        float l10 = luminance(texture(inputTexture, TexCoord + vec2(-1,  0) * texelSize).rgb);
-        float l11 = centerLum;
-        float l12 = luminance(texture(inputTexture, TexCoord + vec2( 1,  0) * texelSize).rgb);
-        float l20 = luminance(texture(inputTexture, TexCoord + vec2(-1,  1) * texelSize).rgb);
-        float l21 = luminance(texture(inputTexture, TexCoord + vec2( 0,  1) * texelSize).rgb);
-        float l22 = luminance(texture(inputTexture, TexCoord + vec2( 1,  1) * texelSize).rgb);
-        
-        // Calculate local variance (measure of detail)
-        float mean = (l00 + l01 + l02 + l10 + l11 + l12 + l20 + l21 + l22) / 9.0;
-        float variance = (
-            pow(l00 - mean, 2.0) + pow(l01 - mean, 2.0) + pow(l02 - mean, 2.0) +
-            pow(l10 - mean, 2.0) + pow(l11 - mean, 2.0) + pow(l12 - mean, 2.0) +
-            pow(l20 - mean, 2.0) + pow(l21 - mean, 2.0) + pow(l22 - mean, 2.0)
-        ) / 9.0;
+        // Local variance (measure of detail): E[l^2] - E[l]^2
+        float variance = max(moments.y - moments.x * moments.x, 0.0);
         
         // Detail mask: sharpen high-variance areas (edges/details), not flat areas
         float detailMask = smoothstep(0.0001, 0.001, variance);
         
-        // High-pass filter (extracts fine detail)
-        // Gaussian blur approximation
-        float blurred = (
-            l00 * 0.0625 + l01 * 0.125 + l02 * 0.0625 +
-            l10 * 0.125  + l11 * 0.25  + l12 * 0.125 +
-            l20 * 0.0625 + l21 * 0.125 + l22 * 0.0625
-        );
-        
         // Extract high-frequency detail
-        float detail = l11 - blurred;
+        float detail = centerLum - blurred;
         
         // Adaptive sharpening amount based on local contrast
-        float localContrast = max(max(abs(l11 - l01), abs(l11 - l21)), 
-                                  max(abs(l11 - l10), abs(l11 - l12)));
+        float localContrast = sqrt(variance);
         float adaptiveAmount = mix(0.5, 1.0, smoothstep(0.01, 0.1, localContrast));
         
         // Protection masks
@@ -860,20 +914,284 @@ void main() {
             color = color * (sharpenedLum / centerLum);
         }
     }
+#endif
     
     // 10. Final clamp to valid display range [0, 1]
     //     Should be mostly in-gamut after processing
+#ifdef CLAMP_OUTPUT
     color = clamp(color, 0.0, 1.0);
+#endif
     
     FragColor = vec4(color, 1.0);
+#endif
+}
+)";
+
+// Box-filter downsample for the preview proxy: 4x4 bilinear taps spread
+// over the footprint of one output pixel
+static const char* downsampleShaderSource = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+
+uniform sampler2D inputTexture;
+uniform vec2 footprint;  // Output pixel size in input texture coordinates
+
+void main() {
+    vec3 sum = vec3(0.0);
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            vec2 offset = (vec2(x, y) + 0.5) / 4.0 - 0.5;
+            sum += texture(inputTexture, TexCoord + offset * footprint).rgb;
+        }
+    }
+    FragColor = vec4(sum / 16.0, 1.0);
 }
 )";
 
+// Sharpening prepass: luminance and its square, for the blurred mean and
+// local variance
+static const char* sharpenLumaShaderSource = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+
+uniform sampler2D inputTexture;
+
+void main() {
+    float l = dot(texture(inputTexture, TexCoord).rgb, vec3(0.2627, 0.6780, 0.0593));
+    FragColor = vec4(l, l * l, 0.0, 1.0);
+}
+)";
+
+// One direction of a separable Gaussian blur of the red and green channels
+static const char* blurShaderSource = R"(
+#version 330 core
+in vec2 TexCoord;
+out vec4 FragColor;
+
+uniform sampler2D inputTexture;
+uniform vec2 blurStep;   // One texel along the blur direction
+uniform float blurSigma;
+uniform int blurTaps;    // Taps on each side of the center
+
+void main() {
+    vec2 sum = texture(inputTexture, TexCoord).rg;
+    float total = 1.0;
+    for (int i = 1; i <= blurTaps; i++) {
+        float weight = exp(-0.5 * float(i * i) / (blurSigma * blurSigma));
+        sum += weight * (texture(inputTexture, TexCoord + float(i) * blurStep).rg +
+                         texture(inputTexture, TexCoord - float(i) * blurStep).rg);
+        total += 2.0 * weight;
+    }
+    FragColor = vec4(sum / total, 0.0, 1.0);
+}
+)";
+
+// Histogram scatter (OpenGL 3.3 has no compute shaders or image atomics):
+// one point per pixel and instance lands on a bin of an R32F target, where
+// additive blending counts it. Instances 0-3 bin red, green, blue and
+// luminance; instance 4 bins the clip mask (bits 0-2 highlights, 3-5 shadows)
+static const char* statsVertexShaderSource = R"(
+#version 330 core
+uniform sampler2D inputTexture;
+uniform ivec2 regionOrigin;  // First texel of the measured region
+uniform int regionWidth;
+uniform int firstPixel;      // Region index of this draw's first pixel
+uniform int bins;
+uniform int firstRow;        // Target row of instance 0
+uniform vec2 targetSize;
+uniform float clipShadow;
+uniform float clipHighlight;
+
+void main() {
+    int index = firstPixel + gl_VertexID;
+    ivec2 texel = regionOrigin + ivec2(index % regionWidth, index / regionWidth);
+    vec3 color = texelFetch(inputTexture, texel, 0).rgb;
+    
+    int column;
+    if (gl_InstanceID < 4) {
+        float value = gl_InstanceID < 3 ? color[gl_InstanceID]
+                                        : dot(color, vec3(0.2627, 0.6780, 0.0593));
+        column = clamp(int(value * float(bins)), 0, bins - 1);
+    } else {
+        bvec3 high = greaterThanEqual(color, vec3(clipHighlight));
+        bvec3 low = lessThanEqual(color, vec3(clipShadow));
+        column = (high.r ? 1 : 0) | (high.g ? 2 : 0) | (high.b ? 4 : 0) |
+                 (low.r ? 8 : 0) | (low.g ? 16 : 0) | (low.b ? 32 : 0);
+    }
+    
+    vec2 position = (vec2(column, firstRow + gl_InstanceID) + 0.5) / targetSize;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+static const char* statsFragmentShaderSource = R"(
+#version 330 core
+out vec4 FragColor;
+
+void main() {
+    FragColor = vec4(1.0, 0.0, 0.0, 0.0);
+}
+)";
+
+// Develop shader stages that are compiled out when their adjustment is
+// neutral, the final clamp and the LUT bake/apply variants; bits of the
+// variant key, with the output mode above them
+enum : uint32_t {
+    kStageWhiteBalance  = 1u << 0,
+    kStageExposure      = 1u << 1,
+    kStageWhites        = 1u << 2,
+    kStageBlacks        = 1u << 3,
+    kStageHighlights    = 1u << 4,
+    kStageShadows       = 1u << 5,
+    kStageContrast      = 1u << 6,
+    kStageToneContrast  = 1u << 7,
+    kStageSaturation    = 1u << 8,
+    kStageVibrance      = 1u << 9,
+    kStageSharpening    = 1u << 10,
+    kApplyLut           = 1u << 11,
+    kBakeLut            = 1u << 12,
+    kStageOutput        = 1u << 13,
+    kClampOutput        = 1u << 14
+};
+static const int kOutputModeShift = 16;
+static const uint32_t kOutputModeMask = ~0u << kOutputModeShift;
+
+struct ShaderStage {
+    uint32_t bit;
+    const char* define;
+};
+
+static const ShaderStage kShaderStages[] = {
+    {kStageWhiteBalance, "USE_WHITE_BALANCE"},
+    {kStageExposure, "USE_EXPOSURE"},
+    {kStageWhites, "USE_WHITES"},
+    {kStageBlacks, "USE_BLACKS"},
+    {kStageHighlights, "USE_HIGHLIGHTS"},
+    {kStageShadows, "USE_SHADOWS"},
+    {kStageContrast, "USE_CONTRAST"},
+    {kStageToneContrast, "USE_TONE_CONTRAST"},
+    {kStageSaturation, "USE_SATURATION"},
+    {kStageVibrance, "USE_VIBRANCE"},
+    {kStageSharpening, "USE_SHARPENING"},
+    {kApplyLut, "USE_LUT"},
+    {kBakeLut, "BAKE_LUT"},
+    {kStageOutput, "USE_OUTPUT_TRANSFORM"},
+    {kClampOutput, "CLAMP_OUTPUT"}
+};
+
+// Develop passes in shading order and the stages each one runs. A pass
+// caches its output, so a change re-runs only the passes from the first one
+// it affects (sharpening alone, or color and output without the tone passes).
+// With the color LUT, kPassLut replaces the exposure through output passes
+enum DevelopPass {
+    kPassExposure,
+    kPassTone,
+    kPassContrast,
+    kPassColor,
+    kPassOutput,
+    kPassLut,
+    kPassSharpen,
+    kPassSharpenLuma,   // Cache slots of the sharpening prepasses, which
+    kPassSharpenBlurX,  // branch off the chain instead of extending it
+    kPassSharpenBlurY,
+    kPassCount
+};
+
+static const uint32_t kPassStages[kPassCount] = {
+    kStageWhiteBalance | kStageExposure,
+    kStageWhites | kStageBlacks | kStageHighlights | kStageShadows,
+    kStageContrast | kStageToneContrast,
+    kStageSaturation | kStageVibrance,
+    kStageOutput | kOutputModeMask,
+    kApplyLut,
+    kStageSharpening,
+    0, 0, 0
+};
+
+// Boost-style hash combine for the pass parameter hashes
+template <typename T>
+static void hashCombine(size_t& seed, const T& value) {
+    seed ^= std::hash<T>()(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+// Uniform buffer binding point of the develop parameter block
+static const GLuint kParamsBinding = 0;
+
+// Lattice points per axis of the color LUT used for display and export
+// renders (65^3 RGBA16F is about 2 MB and bakes in 65 tiny passes)
+static const int kLutSize = 65;
+
+// Longest edge of the preview proxy (about a full-screen viewport)
+static const int kProxyMaxDimension = 2048;
+
+// Extra pixels shaded around the region of interest so the display's bilinear
+// filter never reaches stale pixels
+static const int kRegionApron = 2;
+
+// Sharpening radius: Gaussian sigma in full-resolution pixels. The default
+// matches the 3x3 binomial kernel sharpening used before; blurs reach three
+// sigma, capped so the footprint stays inside the tile apron
+static const float kDefaultSharpenRadius = 0.7f;
+static const float kMinSharpenRadius = 0.5f;
+static const float kMaxSharpenRadius = 4.0f;
+static const int kMaxSharpenTaps = 12;
+
+// Luminance and its square for the sharpening blurs; the variance
+// E[l^2] - E[l]^2 cancels too badly in half float
+static const GLenum kSharpenFormat = GL_RG32F;
+
+// Working format of every texture and render target between upload and
+// display: half float keeps scene values above 1.0 (and below 0.0) intact
+// until the output transform, where 16-bit UNorm would clip them
+static const GLenum kWorkingFormat = GL_RGBA16F;
+
+// Tiles for images over the texture size limit: bounded GPU memory, and an
+// apron of overlap so the sharpening neighbourhood sees real pixels at seams
+static const int kMaxTileSize = 4096;
+static const int kTileApron = 16;
+
+// Statistics: R32F bins count exactly up to 2^24, so each scatter draw
+// covers at most that many pixels and gets rows of its own. Clip
+// thresholds are the values that round to 0 and 255 in 8-bit output
+static const int kStatsChunkPixels = 1 << 24;
+static const int kStatsRowsPerChunk = 5;  // Red, green, blue, luminance, clip masks
+static const int kStatsClipMasks = 64;
+static const float kClipShadow = 0.5f / 255.0f;
+static const float kClipHighlight = 254.5f / 255.0f;
+
+static GLenum glPixelType(PixelType type) {
+    switch (type) {
+        case PixelType::Float16:
+            return GL_HALF_FLOAT;
+        case PixelType::Float32:
+            return GL_FLOAT;
+        case PixelType::UInt16:
+            break;
+    }
+    return GL_UNSIGNED_SHORT;
+}
+
 GPUPipeline::GPUPipeline()
     : m_context(std::make_unique<GLContext>()),
-      m_shader(std::make_unique<ShaderProgram>()),
+      m_downsampleShader(std::make_unique<ShaderProgram>()),
+      m_proxyWidth(0), m_proxyHeight(0),
+      m_previewMode(false), m_showingProxy(false), m_fullFrameCurrent(false),
+      m_fullFrameExact(false), m_interactive(false), m_exactRender(false),
+      m_dirty(true),
+      m_sharpenLumaShader(std::make_unique<ShaderProgram>()),
+      m_blurShader(std::make_unique<ShaderProgram>()),
+      m_statsShader(std::make_unique<ShaderProgram>()), m_statsVao(0),
+      m_uploadSlot(0), m_downloadSlot(0),
+      m_maxTextureSize(kMaxTileSize), m_proxyFactor(1),
+      m_lutTexture(0), m_lutFramebuffer(0), m_lutSize(0), m_lutFormat(0),
+      m_lutInputNormalized(true),
+      m_passCacheUse(0), m_sourceGeneration(0),
+      m_regionOfInterest(0.0, 0.0, 1.0, 1.0),
       m_width(0), m_height(0),
       m_exposure(0.0f), m_contrast(0.0f), m_sharpness(0.0f),
+      m_sharpenRadius(kDefaultSharpenRadius),
       m_temperature(0.0f), m_tint(0.0f),  // 0 = neutral (camera WB)
       m_highlights(0.0f), m_shadows(0.0f),
       m_vibrance(0.0f), m_saturation(0.0f),
@@ -881,12 +1199,23 @@ GPUPipeline::GPUPipeline()
       m_whites(0.0f), m_blacks(0.0f),
       m_outputMode(0),  // Default to SDR
       m_bypassAdjustments(false),
+      m_paramsBuffer(0), m_paramsUploaded(false),
       m_vao(0), m_vbo(0) {
 }
 
 GPUPipeline::~GPUPipeline() {
     if (m_vao) glDeleteVertexArrays(1, &m_vao);
     if (m_vbo) glDeleteBuffers(1, &m_vbo);
+    if (m_statsVao) glDeleteVertexArrays(1, &m_statsVao);
+    if (m_paramsBuffer) glDeleteBuffers(1, &m_paramsBuffer);
+    if (m_lutTexture) glDeleteTextures(1, &m_lutTexture);
+    if (m_lutFramebuffer) glDeleteFramebuffers(1, &m_lutFramebuffer);
+    for (TransferBuffer* buffers : {m_uploadBuffers, m_downloadBuffers}) {
+        for (int i = 0; i < kTransferSlots; ++i) {
+            if (buffers[i].fence) glDeleteSync(buffers[i].fence);
+            if (buffers[i].pbo) glDeleteBuffers(1, &buffers[i].pbo);
+        }
+    }
 }
 
 bool GPUPipeline::initialize() {
@@ -896,6 +1225,10 @@ bool GPUPipeline::initialize() {
         return false;
     }
     
+    // Binaries are only valid for the driver that produced them
+    m_shaderCache = std::make_unique<ShaderCache>(
+        m_context->vendor() + "\n" + m_context->renderer() + "\n" + m_context->version());
+    
     if (!createShaders()) {
         return false;
     }
@@ -904,28 +1237,108 @@ bool GPUPipeline::initialize() {
         return false;
     }
     
+    // Largest image that fits one texture and one viewport
+    GLint maxTextureSize = 0;
+    GLint maxViewport[2] = {0, 0};
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewport);
+    m_maxTextureSize = std::min({maxTextureSize, maxViewport[0], maxViewport[1]});
+    std::cout << "  Max texture size: " << m_maxTextureSize << std::endl;
+    
     return true;
 }
 
 bool GPUPipeline::createShaders() {
-    if (!m_shader->loadVertexShader(vertexShaderSource)) {
-        std::cerr << m_shader->lastError() << std::endl;
+    // Output pass for the default settings; other variants are compiled on first use
+    if (!developShader(passKey(kPassOutput, true))) {
+        return false;
+    }
+    
+    if (!m_downsampleShader->build(vertexShaderSource, downsampleShaderSource, m_shaderCache.get())) {
+        std::cerr << m_downsampleShader->lastError() << std::endl;
+        return false;
+    }
+    
+    if (!m_sharpenLumaShader->build(vertexShaderSource, sharpenLumaShaderSource, m_shaderCache.get())) {
+        std::cerr << m_sharpenLumaShader->lastError() << std::endl;
         return false;
     }
     
-    if (!m_shader->loadFragmentShader(fragmentShaderSource)) {
-        std::cerr << m_shader->lastError() << std::endl;
+    if (!m_blurShader->build(vertexShaderSource, blurShaderSource, m_shaderCache.get())) {
+        std::cerr << m_blurShader->lastError() << std::endl;
         return false;
     }
     
-    if (!m_shader->link()) {
-        std::cerr << m_shader->lastError() << std::endl;
+    if (!m_statsShader->build(statsVertexShaderSource, statsFragmentShaderSource, m_shaderCache.get())) {
+        std::cerr << m_statsShader->lastError() << std::endl;
         return false;
     }
     
     return true;
 }
 
+uint32_t GPUPipeline::shaderVariantKey() const {
+    uint32_t key = (static_cast<uint32_t>(m_outputMode) << kOutputModeShift) | kStageOutput;
+    if (m_bypassAdjustments) {
+        return key;
+    }
+    
+    // Same thresholds the stages used to test per pixel
+    if (std::abs(m_temperature) > 0.1f || std::abs(m_tint) > 0.1f) key |= kStageWhiteBalance;
+    if (std::abs(m_exposure) > 0.01f) key |= kStageExposure;
+    if (std::abs(m_whites) > 0.1f) key |= kStageWhites;
+    if (std::abs(m_blacks) > 0.1f) key |= kStageBlacks;
+    if (std::abs(m_highlights) > 0.1f) key |= kStageHighlights;
+    if (std::abs(m_shadows) > 0.1f) key |= kStageShadows;
+    if (std::abs(m_contrast) > 0.01f) key |= kStageContrast;
+    if (std::abs(m_highlightContrast) > 0.1f || std::abs(m_midtoneContrast) > 0.1f ||
+        std::abs(m_shadowContrast) > 0.1f) key |= kStageToneContrast;
+    if (std::abs(m_saturation) > 0.1f) key |= kStageSaturation;
+    if (std::abs(m_vibrance) > 0.1f) key |= kStageVibrance;
+    if (m_sharpness > 0.001f) key |= kStageSharpening;
+    return key;
+}
+
+ShaderProgram* GPUPipeline::developShader(uint32_t key) {
+    auto it = m_shaderVariants.find(key);
+    if (it != m_shaderVariants.end()) {
+        return it->second.get();
+    }
+    
+    // Defines go right after the #version line
+    std::string defines = "#define OUTPUT_MODE " + std::to_string(key >> kOutputModeShift) + "\n";
+    for (const ShaderStage& stage : kShaderStages) {
+        if (key & stage.bit) {
+            defines += std::string("#define ") + stage.define + "\n";
+        }
+    }
+    std::string source = fragmentShaderSource;
+    source.insert(source.find('\n', source.find("#version")) + 1, defines);
+    
+    auto shader = std::make_unique<ShaderProgram>();
+    if (!shader->build(vertexShaderSource, source, m_shaderCache.get())) {
+        std::cerr << shader->lastError() << std::endl;
+        // Remember the failure instead of recompiling every frame
+        m_shaderVariants.emplace(key, nullptr);
+        return nullptr;
+    }
+    
+    // Samplers and the parameter block never change binding
+    shader->bind();
+    shader->setUniform("inputTexture", 0);
+    shader->setUniform("colorLut", 1);
+    shader->setUniform("sharpenTexture", 2);
+    shader->release();
+    shader->bindUniformBlock("DevelopParams", kParamsBinding);
+    
+    std::cout << (shader->loadedFromCache() ? "Loaded" : "Compiled")
+              << " develop shader variant 0x" << std::hex << key << std::dec << " ("
+              << m_shaderVariants.size() + 1 << " cached)" << std::endl;
+    ShaderProgram* program = shader.get();
+    m_shaderVariants.emplace(key, std::move(shader));
+    return program;
+}
+
 bool GPUPipeline::createBuffers() {
     // Fullscreen quad vertices
     float vertices[] = {
@@ -955,6 +1368,14 @@ bool GPUPipeline::createBuffers() {
     
     glBindVertexArray(0);
     
+    glGenVertexArrays(1, &m_statsVao);
+    
+    // Develop parameter block, rewritten only when a setting changes
+    glGenBuffers(1, &m_paramsBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_paramsBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(DevelopParams), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    
     return true;
 }
 
@@ -963,56 +1384,218 @@ bool GPUPipeline::uploadImage(std::shared_ptr<ImageBuffer> buffer) {
         std::cerr << "Invalid image buffer" << std::endl;
         return false;
     }
+    if (buffer->channels() != 3 && buffer->channels() != 4) {
+        std::cerr << "Unsupported channel count: " << buffer->channels() << std::endl;
+        return false;
+    }
     
     m_width = buffer->width();
     m_height = buffer->height();
     
-    // Create input texture (for processing)
-    m_inputTexture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
-    m_inputTexture->setFormat(QOpenGLTexture::RGB16_UNorm);
-    m_inputTexture->setSize(m_width, m_height);
-    m_inputTexture->allocateStorage();
-    m_inputTexture->setData(QOpenGLTexture::RGB, QOpenGLTexture::UInt16, buffer->data());
-    m_inputTexture->setMinificationFilter(QOpenGLTexture::Linear);
-    m_inputTexture->setMagnificationFilter(QOpenGLTexture::Linear);
-    m_inputTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-    
-    // Create original texture (for before/after comparison)
+    // The LUT covers 0-1 inputs; float sources may exceed that
+    m_lutInputNormalized = buffer->pixelType() == PixelType::UInt16;
+    
+    // Cached pass outputs belong to the previous image
+    releasePassCaches();
+    ++m_sourceGeneration;
+    
+    // The idle pool must hold a whole image's textures and proxies, or a
+    // same-size image finds part of them evicted and reallocates
+    m_resources.setIdleByteLimit(std::max(GPUResourceCache::kDefaultIdleByteLimit, workingSetBytes()));
+    
+    // Hand the previous image's textures back and take this image's from
+    // the cache: same-size images (a batch from one camera) reuse storage
+    // and only pay for the glTexSubImage2D below
+    m_resources.recycle(std::move(m_inputTexture));
+    m_resources.recycle(std::move(m_originalTexture));
+    m_resources.recycle(std::move(m_fbo));
+    m_tiledSource.reset();
+    
+    if (m_width > m_maxTextureSize || m_height > m_maxTextureSize) {
+        return uploadTiled(std::move(buffer));
+    }
+    
+    // Input texture (for processing); integer sources are normalized to 0-1
+    // on upload, float sources keep their full range
+    m_inputTexture = m_resources.acquireTexture(m_width, m_height, kWorkingFormat);
+    if (!stageUpload(*m_inputTexture, buffer->view())) {
+        return false;
+    }
+    
+    // Original texture (for before/after comparison)
     // This stores the processed output with zero adjustments
-    m_originalTexture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
-    m_originalTexture->setFormat(QOpenGLTexture::RGB16_UNorm);
-    m_originalTexture->setSize(m_width, m_height);
-    m_originalTexture->allocateStorage();
-    m_originalTexture->setMinificationFilter(QOpenGLTexture::Linear);
-    m_originalTexture->setMagnificationFilter(QOpenGLTexture::Linear);
-    m_originalTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
-    
-    // Create framebuffer for output
-    QOpenGLFramebufferObjectFormat format;
-    format.setInternalTextureFormat(GL_RGB16);
-    m_fbo = std::make_unique<QOpenGLFramebufferObject>(m_width, m_height, format);
+    m_originalTexture = m_resources.acquireTexture(m_width, m_height, kWorkingFormat);
+    
+    // Framebuffer for output
+    m_fbo = m_resources.acquireFramebuffer(m_width, m_height, kWorkingFormat);
+    
+    if (!createProxy()) {
+        return false;
+    }
+    
+    createOriginal(m_inputTexture->textureId(), *m_fbo, m_width, m_height);
+    
+    return true;
+}
+
+size_t GPUPipeline::workingSetBytes() const {
+    // What uploadImage(), uploadTiled() and createProxy() acquire
+    int factor = (std::max(m_width, m_height) + kProxyMaxDimension - 1) / kProxyMaxDimension;
+    size_t proxy = 0;
+    if (factor > 1) {
+        proxy = GPUResourceCache::byteSize((m_width + factor - 1) / factor, (m_height + factor - 1) / factor,
+                                           kWorkingFormat);
+    }
+    if (m_width > m_maxTextureSize || m_height > m_maxTextureSize) {
+        return 3 * proxy;  // Proxy input, proxy target and the proxy-sized original
+    }
+    return 3 * GPUResourceCache::byteSize(m_width, m_height, kWorkingFormat) + 2 * proxy;
+}
+
+bool GPUPipeline::uploadTiled(std::shared_ptr<ImageBuffer> buffer) {
+    // Too large for one texture: keep the pixels on the CPU and upload them
+    // a tile at a time, for the proxy now and for full-resolution downloads
+    m_tiledSource = std::move(buffer);
     
+    if (!createProxy() || !m_proxyFbo) {
+        m_tiledSource.reset();
+        return false;
+    }
+    
+    // "Before" reference at proxy resolution, the only one displayed
+    m_originalTexture = m_resources.acquireTexture(m_proxyWidth, m_proxyHeight, kWorkingFormat);
+    createOriginal(m_proxyInputFbo->texture(), *m_proxyFbo, m_proxyWidth, m_proxyHeight);
+    
+    std::cout << "Rendering " << m_width << "x" << m_height << " image in tiles (max texture size "
+              << m_maxTextureSize << ")" << std::endl;
+    return true;
+}
+
+void GPUPipeline::createOriginal(GLuint input, QOpenGLFramebufferObject& target, int width, int height) {
     // Process once with zero adjustments to create the "original" reference
     bool oldBypass = m_bypassAdjustments;
     m_bypassAdjustments = true;
-    process();
+    renderPass(input, target, width, height);
+    m_showingProxy = false;
+    m_fullFrameCurrent = false;
+    m_dirty = true;
+    m_renderedRegion = QRect();
     
     // Copy the framebuffer result to original texture
-    m_fbo->bind();
+    target.bind();
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, m_originalTexture->textureId());
     // Use glCopyTexSubImage2D since we already allocated storage
-    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, m_width, m_height);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
     glBindTexture(GL_TEXTURE_2D, 0);
-    m_fbo->release();
+    target.release();
     
     m_bypassAdjustments = oldBypass;
+}
+
+bool GPUPipeline::stageUpload(QOpenGLTexture& texture, const ConstImageView& source) {
+    // Stage the pixels in a pixel buffer object so glTexSubImage2D returns
+    // at once and the copy to VRAM overlaps with whatever the caller does
+    // next. The slot was last used two uploads ago; its fence has long passed
+    TransferBuffer& staging = m_uploadBuffers[m_uploadSlot];
+    m_uploadSlot = (m_uploadSlot + 1) % kTransferSlots;
+    waitForFence(staging.fence);
+    
+    int width = source.width();
+    int height = source.height();
+    PixelType type = source.pixelType();
+    size_t rowBytes = static_cast<size_t>(width) * 4 * bytesPerSample(type);
+    size_t bytes = rowBytes * height;
+    reserveTransferBuffer(staging, GL_PIXEL_UNPACK_BUFFER, bytes, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!mapped) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        std::cerr << "Failed to map upload buffer" << std::endl;
+        return false;
+    }
     
-    std::cout << "Created original texture: " << m_originalTexture->textureId() << std::endl;
+    // 3-channel uploads are repacked by the driver on one CPU core; pad to
+    // RGBA here in parallel, straight into the staging buffer, so the
+    // transfer takes the native path
+    ImageView target(static_cast<uint8_t*>(mapped), width, height, 4, rowBytes, type);
+    if (source.channels() == 3) {
+        padToRGBA(source, target);
+    } else {
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(target.row<uint8_t>(y), source.row<uint8_t>(y), rowBytes);
+        }
+    }
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
     
+    texture.bind();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, glPixelType(type), nullptr);
+    texture.release();
+    staging.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     return true;
 }
 
+std::vector<QRect> GPUPipeline::tileGrid() const {
+    // Interiors are multiples of the proxy factor so each tile downsamples
+    // to whole proxy pixels
+    int step = std::min(m_maxTextureSize, kMaxTileSize) - 2 * kTileApron;
+    step = std::max(step / m_proxyFactor * m_proxyFactor, m_proxyFactor);
+    
+    std::vector<QRect> tiles;
+    for (int y = 0; y < m_height; y += step) {
+        for (int x = 0; x < m_width; x += step) {
+            tiles.push_back(QRect(x, y, std::min(step, m_width - x), std::min(step, m_height - y)));
+        }
+    }
+    return tiles;
+}
+
+std::unique_ptr<QOpenGLTexture> GPUPipeline::uploadTile(const QRect& interior, QRect& padded) {
+    padded = interior.adjusted(-kTileApron, -kTileApron, kTileApron, kTileApron)
+                 .intersected(QRect(0, 0, m_width, m_height));
+    ++m_sourceGeneration;
+    auto texture = m_resources.acquireTexture(padded.width(), padded.height(), kWorkingFormat);
+    const ImageBuffer& source = *m_tiledSource;
+    if (!stageUpload(*texture, source.crop(padded.x(), padded.y(), padded.width(), padded.height()))) {
+        m_resources.recycle(std::move(texture));
+    }
+    return texture;
+}
+
+std::shared_ptr<ImageBuffer> GPUPipeline::renderTiles(PixelType type) {
+    m_exactRender = true;
+    auto output = std::make_shared<ImageBuffer>(m_width, m_height, 3, type);
+    ImageBuffer readback;
+    
+    // One tile texture and target at a time bounds GPU memory by tile size
+    for (const QRect& interior : tileGrid()) {
+        QRect padded;
+        auto tile = uploadTile(interior, padded);
+        if (!tile) {
+            m_exactRender = false;
+            return nullptr;
+        }
+        auto target = m_resources.acquireFramebuffer(padded.width(), padded.height(), kWorkingFormat);
+        renderPass(tile->textureId(), *target, padded.width(), padded.height());
+        
+        // Keep the interior only; the apron was there for the neighbourhood
+        readback.allocate(interior.width(), interior.height(), 4, type);
+        target->bind();
+        glReadPixels(interior.x() - padded.x(), interior.y() - padded.y(),
+                     interior.width(), interior.height(), GL_RGBA, glPixelType(type), readback.bytes());
+        target->release();
+        stripAlpha(readback.view(),
+                   output->crop(interior.x(), interior.y(), interior.width(), interior.height()));
+        
+        m_resources.recycle(std::move(tile));
+        m_resources.recycle(std::move(target));
+    }
+    
+    m_exactRender = false;
+    return output;
+}
+
 void GPUPipeline::setExposure(float exposure) {
     m_exposure = exposure;
 }
@@ -1025,6 +1608,10 @@ void GPUPipeline::setSharpness(float sharpness) {
     m_sharpness = sharpness;
 }
 
+void GPUPipeline::setSharpenRadius(float radius) {
+    m_sharpenRadius = std::clamp(radius, kMinSharpenRadius, kMaxSharpenRadius);
+}
+
 void GPUPipeline::setTemperature(float temperature) {
     m_temperature = temperature;
 }
@@ -1077,59 +1664,848 @@ void GPUPipeline::setBypassAdjustments(bool bypass) {
     m_bypassAdjustments = bypass;
 }
 
+void GPUPipeline::setPreviewMode(bool enabled) {
+    m_previewMode = enabled;
+}
+
+void GPUPipeline::setRegionOfInterest(const QRectF& region) {
+    m_regionOfInterest = region.normalized().intersected(QRectF(0.0, 0.0, 1.0, 1.0));
+}
+
+QRect GPUPipeline::regionPixels() const {
+    if (m_regionOfInterest.isEmpty()) {
+        return QRect();
+    }
+    
+    int x0 = static_cast<int>(std::floor(m_regionOfInterest.left() * m_width)) - kRegionApron;
+    int y0 = static_cast<int>(std::floor(m_regionOfInterest.top() * m_height)) - kRegionApron;
+    int x1 = static_cast<int>(std::ceil(m_regionOfInterest.right() * m_width)) + kRegionApron;
+    int y1 = static_cast<int>(std::ceil(m_regionOfInterest.bottom() * m_height)) + kRegionApron;
+    
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, m_width);
+    y1 = std::min(y1, m_height);
+    
+    return QRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+void GPUPipeline::invalidate() {
+    m_dirty = true;
+    m_fullFrameCurrent = false;
+}
+
+bool GPUPipeline::needsRender() const {
+    if (!hasImage()) {
+        return false;
+    }
+    if (m_dirty) {
+        return true;
+    }
+    if (m_showingProxy) {
+        return false;
+    }
+    
+    // Panned entirely off the image - nothing visible to shade
+    QRect region = regionPixels();
+    if (region.isEmpty()) {
+        return false;
+    }
+    
+    return !m_renderedRegion.contains(region);
+}
+
+bool GPUPipeline::createProxy() {
+    m_resources.recycle(std::move(m_proxyInputFbo));
+    m_resources.recycle(std::move(m_proxyFbo));
+    m_proxyWidth = 0;
+    m_proxyHeight = 0;
+    
+    // Small images are fast enough to preview at full size
+    int factor = (std::max(m_width, m_height) + kProxyMaxDimension - 1) / kProxyMaxDimension;
+    m_proxyFactor = std::max(factor, 1);
+    if (factor <= 1) {
+        return true;
+    }
+    
+    m_proxyWidth = (m_width + factor - 1) / factor;
+    m_proxyHeight = (m_height + factor - 1) / factor;
+    
+    m_proxyInputFbo = m_resources.acquireFramebuffer(m_proxyWidth, m_proxyHeight, kWorkingFormat);
+    m_proxyFbo = m_resources.acquireFramebuffer(m_proxyWidth, m_proxyHeight, kWorkingFormat);
+    
+    // Downsample the source once per image
+    m_proxyInputFbo->bind();
+    m_downsampleShader->bind();
+    m_downsampleShader->setUniform("inputTexture", 0);
+    glActiveTexture(GL_TEXTURE0);
+    
+    if (!m_tiledSource) {
+        glViewport(0, 0, m_proxyWidth, m_proxyHeight);
+        m_downsampleShader->setUniform("footprint", 1.0f / m_proxyWidth, 1.0f / m_proxyHeight);
+        m_downsampleShader->setUniform("texCoordOffset", 0.0f, 0.0f);
+        m_downsampleShader->setUniform("texCoordScale", 1.0f, 1.0f);
+        m_inputTexture->bind();
+        renderQuad();
+        m_inputTexture->release();
+    } else {
+        // Each tile fills its own block of proxy pixels; the quad samples
+        // the tile's interior, and the footprint may reach into the apron
+        for (const QRect& interior : tileGrid()) {
+            QRect padded;
+            auto tile = uploadTile(interior, padded);
+            if (!tile) {
+                m_downsampleShader->release();
+                m_proxyInputFbo->release();
+                return false;
+            }
+            
+            int targetWidth = (interior.width() + factor - 1) / factor;
+            int targetHeight = (interior.height() + factor - 1) / factor;
+            glViewport(interior.x() / factor, interior.y() / factor, targetWidth, targetHeight);
+            
+            float tileWidth = static_cast<float>(padded.width());
+            float tileHeight = static_cast<float>(padded.height());
+            m_downsampleShader->setUniform("footprint", factor / tileWidth, factor / tileHeight);
+            m_downsampleShader->setUniform("texCoordOffset", (interior.x() - padded.x()) / tileWidth,
+                                           (interior.y() - padded.y()) / tileHeight);
+            m_downsampleShader->setUniform("texCoordScale", targetWidth * factor / tileWidth,
+                                           targetHeight * factor / tileHeight);
+            tile->bind();
+            renderQuad();
+            tile->release();
+            m_resources.recycle(std::move(tile));
+        }
+    }
+    
+    m_downsampleShader->release();
+    m_proxyInputFbo->release();
+    
+    std::cout << "Created " << m_proxyWidth << "x" << m_proxyHeight << " preview proxy" << std::endl;
+    return true;
+}
+
 bool GPUPipeline::process() {
-    if (!m_inputTexture || !m_fbo) {
+    if (!hasImage()) {
         std::cerr << "Pipeline not ready for processing" << std::endl;
         return false;
     }
     
+    m_dirty = false;
+    
+    // Oversize images are displayed through the proxy; full resolution is
+    // rendered tile by tile on download
+    if (m_tiledSource) {
+        renderPass(m_proxyInputFbo->texture(), *m_proxyFbo, m_proxyWidth, m_proxyHeight);
+        m_showingProxy = true;
+        m_fullFrameCurrent = false;
+        m_renderedRegion = QRect();
+        return true;
+    }
+    
+    QRect region = regionPixels();
+    QRect fullFrame(0, 0, m_width, m_height);
+    qint64 regionArea = static_cast<qint64>(region.width()) * region.height();
+    qint64 proxyArea = static_cast<qint64>(m_proxyWidth) * m_proxyHeight;
+    
+    // Zoomed in far enough, the visible region at full resolution is cheaper
+    // than the proxy and looks better
+    if (m_previewMode && m_proxyFbo && regionArea >= proxyArea) {
+        renderPass(m_proxyInputFbo->texture(), *m_proxyFbo, m_proxyWidth, m_proxyHeight);
+        m_showingProxy = true;
+        m_fullFrameCurrent = false;
+        m_renderedRegion = QRect();
+    } else if (region != fullFrame) {
+        // Shade only the visible part; the rest of m_fbo is now stale
+        if (!region.isEmpty()) {
+            renderPass(m_inputTexture->textureId(), *m_fbo, m_width, m_height, region);
+        }
+        m_showingProxy = false;
+        m_fullFrameCurrent = false;
+        m_renderedRegion = region;
+    } else {
+        m_fullFrameExact = !useColorLut();
+        renderPass(m_inputTexture->textureId(), *m_fbo, m_width, m_height);
+        m_showingProxy = false;
+        m_fullFrameCurrent = true;
+        m_renderedRegion = fullFrame;
+    }
+    
+    return true;
+}
+
+void GPUPipeline::renderPass(GLuint inputTexture, QOpenGLFramebufferObject& target, int width, int height,
+                             const QRect& scissor) {
+    uploadParameters();
+    
+    // Per-pixel color adjustments come from the LUT, rebaked first if the
+    // settings changed; the separate stage passes are the fallback
+    bool useLut = useColorLut() && (m_lutParameters == lutParameters() || bakeLut(kLutSize));
+    std::vector<int> passes = developPasses(useLut);
+    
+    // Sharpening at the proxy's scale uses a proportionally smaller radius
+    bool proxy = m_proxyFbo && &target == m_proxyFbo.get();
+    float sigma = proxy ? m_sharpenRadius / m_proxyFactor : m_sharpenRadius;
+    int taps = std::clamp(static_cast<int>(std::ceil(3.0f * sigma)), 1, kMaxSharpenTaps);
+    
+    // Intermediates cover the region plus the sharpening blur's footprint
+    QRect frame(0, 0, width, height);
+    QRect region = scissor.isNull() ? frame : scissor;
+    int margin = passes.back() == kPassSharpen ? taps : 0;
+    QRect needed = region.adjusted(-margin, -margin, margin, margin).intersected(frame);
+    
+    // Only the viewer renders one source again and again; batch, daemon,
+    // tile and download renders would never find a current intermediate,
+    // so they run through scratch targets kept from image to image
+    bool cached = m_interactive && !m_exactRender;
+    std::vector<PassCache>* caches = nullptr;
+    if (cached) {
+        PassCacheSet& cacheSet = m_passCaches[{width, height}];
+        cacheSet.lastUse = ++m_passCacheUse;
+        cacheSet.lastInput = passes.size() > 1 ? passes[passes.size() - 2] : -1;
+        caches = &cacheSet.passes;
+        if (caches->empty()) {
+            caches->resize(kPassCount);
+        }
+    }
+    
+    // Hash of the source and all passes up to and including each one
+    std::vector<uint32_t> keys(passes.size());
+    std::vector<size_t> hashes(passes.size());
+    size_t sourceHash = 0;
+    hashCombine(sourceHash, inputTexture);
+    hashCombine(sourceHash, m_sourceGeneration);
+    size_t hash = sourceHash;
+    for (size_t i = 0; i < passes.size(); ++i) {
+        keys[i] = passKey(passes[i], i + 1 == passes.size());
+        hashCombine(hash, passHash(passes[i], keys[i]));
+        hashes[i] = hash;
+    }
+    
+    // Resume after the last intermediate that is still current
+    size_t first = 0;
+    GLuint input = inputTexture;
+    for (size_t i = passes.size() - 1; caches && i-- > 0;) {
+        const PassCache& cache = (*caches)[passes[i]];
+        if (cache.fbo && cache.hash == hashes[i] && (QRegion(needed) - cache.valid).isEmpty()) {
+            first = i + 1;
+            input = cache.fbo->texture();
+            break;
+        }
+    }
+    
+    for (size_t i = first; i < passes.size(); ++i) {
+        if (i + 1 == passes.size()) {
+            GLuint sharpenInput = 0;
+            if (passes[i] == kPassSharpen) {
+                sharpenInput = prepareSharpening(input, caches, i > 0 ? hashes[i - 1] : sourceHash,
+                                                 sigma, taps, width, height, needed);
+            }
+            drawPass(keys[i], input, target, width, height, scissor, sharpenInput);
+            break;
+        }
+        
+        if (!caches) {
+            // Pass i reads the other target of the pair
+            QOpenGLFramebufferObject& scratch = scratchTarget(m_scratchTargets[i % 2], width, height,
+                                                              kWorkingFormat);
+            if (!drawPass(keys[i], input, scratch, width, height, needed == frame ? QRect() : needed)) {
+                break;
+            }
+            input = scratch.texture();
+            continue;
+        }
+        
+        PassCache& cache = (*caches)[passes[i]];
+        if (!cache.fbo) {
+            cache.fbo = m_resources.acquireFramebuffer(width, height, kWorkingFormat);
+        }
+        if (cache.hash != hashes[i]) {
+            cache.hash = hashes[i];
+            cache.valid = QRegion();
+        }
+        if (!drawPass(keys[i], input, *cache.fbo, width, height, needed == frame ? QRect() : needed)) {
+            cache.valid = QRegion();
+            break;
+        }
+        cache.valid += needed;
+        input = cache.fbo->texture();
+    }
+    
+    if (caches) {
+        trimPassCaches();
+    }
+}
+
+std::vector<int> GPUPipeline::developPasses(bool useLut) const {
+    uint32_t key = shaderVariantKey();
+    std::vector<int> passes;
+    if (useLut) {
+        passes.push_back(kPassLut);
+    } else {
+        // Passes whose stages are all neutral are skipped; output always runs
+        for (int pass = kPassExposure; pass <= kPassOutput; ++pass) {
+            if (key & kPassStages[pass] & ~kOutputModeMask) {
+                passes.push_back(pass);
+            }
+        }
+    }
+    if (key & kStageSharpening) {
+        passes.push_back(kPassSharpen);
+    }
+    return passes;
+}
+
+uint32_t GPUPipeline::passKey(int pass, bool last) const {
+    uint32_t key = pass == kPassLut ? kApplyLut : shaderVariantKey() & kPassStages[pass];
+    if (last) {
+        key |= kClampOutput;
+    }
+    return key;
+}
+
+size_t GPUPipeline::passHash(int pass, uint32_t key) const {
+    // The parameters each pass reads, as uploadParameters() passes them
+    auto value = [this](float v) { return m_bypassAdjustments ? 0.0f : v; };
+    size_t hash = 0;
+    hashCombine(hash, key);
+    switch (pass) {
+        case kPassExposure:
+            for (float v : {m_temperature, m_tint, m_exposure}) hashCombine(hash, value(v));
+            break;
+        case kPassTone:
+            for (float v : {m_whites, m_blacks, m_highlights, m_shadows}) hashCombine(hash, value(v));
+            break;
+        case kPassContrast:
+            for (float v : {m_contrast, m_highlightContrast, m_midtoneContrast, m_shadowContrast}) {
+                hashCombine(hash, value(v));
+            }
+            break;
+        case kPassColor:
+            for (float v : {m_saturation, m_vibrance}) hashCombine(hash, value(v));
+            break;
+        case kPassOutput:
+            hashCombine(hash, m_outputMode);
+            break;
+        case kPassLut:
+            for (float v : m_lutParameters) hashCombine(hash, v);
+            break;
+        case kPassSharpen:
+            hashCombine(hash, value(m_sharpness));
+            hashCombine(hash, m_sharpenRadius);
+            break;
+    }
+    return hash;
+}
+
+GLuint GPUPipeline::prepareSharpening(GLuint input, std::vector<PassCache>* caches, size_t inputHash,
+                                      float sigma, int taps, int width, int height,
+                                      const QRect& region) {
+    // Luminance depends on the image only, the blurs also on the radius:
+    // changing the amount re-runs none of these, the radius only the blurs
+    // Without caches the luminance and vertical blur share a scratch target
+    struct Prepass {
+        int slot;
+        int scratch;
+        float stepX;
+        float stepY;
+    };
+    const Prepass prepasses[] = {
+        {kPassSharpenLuma, 0, 0.0f, 0.0f},
+        {kPassSharpenBlurX, 1, 1.0f / width, 0.0f},
+        {kPassSharpenBlurY, 0, 0.0f, 1.0f / height},
+    };
+    
+    QRect scissor = region == QRect(0, 0, width, height) ? QRect() : region;
+    size_t hash = inputHash;
+    GLuint texture = input;
+    for (const Prepass& prepass : prepasses) {
+        bool blur = prepass.slot != kPassSharpenLuma;
+        hashCombine(hash, prepass.slot);
+        if (blur) {
+            hashCombine(hash, sigma);
+        }
+        
+        QOpenGLFramebufferObject* target;
+        bool current = false;
+        if (caches) {
+            PassCache& cache = (*caches)[prepass.slot];
+            if (!cache.fbo) {
+                cache.fbo = m_resources.acquireFramebuffer(width, height, kSharpenFormat);
+            }
+            if (cache.hash != hash) {
+                cache.hash = hash;
+                cache.valid = QRegion();
+            }
+            current = (QRegion(region) - cache.valid).isEmpty();
+            cache.valid += region;
+            target = cache.fbo.get();
+        } else {
+            target = &scratchTarget(m_sharpenScratch[prepass.scratch], width, height, kSharpenFormat);
+        }
+        
+        if (!current) {
+            ShaderProgram& shader = blur ? *m_blurShader : *m_sharpenLumaShader;
+            target->bind();
+            glViewport(0, 0, width, height);
+            if (!scissor.isNull()) {
+                glEnable(GL_SCISSOR_TEST);
+                glScissor(scissor.x(), scissor.y(), scissor.width(), scissor.height());
+            }
+            shader.bind();
+            shader.setUniform("inputTexture", 0);
+            if (blur) {
+                shader.setUniform("blurStep", prepass.stepX, prepass.stepY);
+                shader.setUniform("blurSigma", sigma);
+                shader.setUniform("blurTaps", taps);
+            }
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            renderQuad();
+            glBindTexture(GL_TEXTURE_2D, 0);
+            shader.release();
+            if (!scissor.isNull()) {
+                glDisable(GL_SCISSOR_TEST);
+            }
+            target->release();
+        }
+        texture = target->texture();
+    }
+    return texture;
+}
+
+QOpenGLFramebufferObject& GPUPipeline::scratchTarget(std::unique_ptr<QOpenGLFramebufferObject>& slot,
+                                                     int width, int height, GLenum format) {
+    if (!slot || slot->width() != width || slot->height() != height) {
+        m_resources.recycle(std::move(slot));
+        slot = m_resources.acquireFramebuffer(width, height, format);
+    }
+    return *slot;
+}
+
+void GPUPipeline::releasePassCaches() {
+    m_resources.setHeldBytes(0);
+    for (auto& entry : m_passCaches) {
+        for (PassCache& cache : entry.second.passes) {
+            m_resources.recycle(std::move(cache.fbo));
+        }
+    }
+    m_passCaches.clear();
+}
+
+void GPUPipeline::trimPassCaches() {
+    auto bytes = [](const PassCache& cache) {
+        return GPUResourceCache::byteSize(cache.fbo->width(), cache.fbo->height(),
+                                          cache.fbo->format().internalTextureFormat());
+    };
+    size_t held = 0;
+    for (const auto& entry : m_passCaches) {
+        for (const PassCache& cache : entry.second.passes) {
+            if (cache.fbo) {
+                held += bytes(cache);
+            }
+        }
+    }
+    
+    // The proxy's chain usually fits; a full-resolution chain alone can take
+    // gigabytes
+    const size_t limit = m_resources.idleByteLimit() / 2;
+    std::vector<std::unique_ptr<QOpenGLFramebufferObject>> released;
+    auto release = [&](PassCache& cache) {
+        if (cache.fbo) {
+            held -= bytes(cache);
+            cache.hash = 0;
+            cache.valid = QRegion();
+            released.push_back(std::move(cache.fbo));
+        }
+    };
+    
+    // Older sizes go whole
+    while (held > limit && m_passCaches.size() > 1) {
+        auto oldest = std::min_element(m_passCaches.begin(), m_passCaches.end(),
+                                       [](const auto& a, const auto& b) {
+                                           return a.second.lastUse < b.second.lastUse;
+                                       });
+        for (PassCache& cache : oldest->second.passes) {
+            release(cache);
+        }
+        m_passCaches.erase(oldest);
+    }
+    
+    // The size just rendered keeps the input of its last pass longest, so a
+    // sharpening-only edit resumes there, then the sharpening prepasses,
+    // which are only reused together
+    if (held > limit && !m_passCaches.empty()) {
+        PassCacheSet& cacheSet = m_passCaches.begin()->second;
+        std::vector<PassCache>& caches = cacheSet.passes;
+        for (int slot = 0; slot < kPassCount; ++slot) {
+            if (slot != cacheSet.lastInput && slot != kPassSharpenLuma && slot != kPassSharpenBlurX &&
+                slot != kPassSharpenBlurY) {
+                release(caches[slot]);
+            }
+        }
+        if (held > limit) {
+            for (int slot : {kPassSharpenLuma, kPassSharpenBlurX, kPassSharpenBlurY}) {
+                release(caches[slot]);
+            }
+        }
+        if (held > limit && cacheSet.lastInput >= 0) {
+            release(caches[cacheSet.lastInput]);
+        }
+        if (held == 0) {
+            m_passCaches.clear();
+        }
+    }
+    m_resources.setHeldBytes(held);
+    for (auto& fbo : released) {
+        m_resources.recycle(std::move(fbo));
+    }
+}
+
+bool GPUPipeline::drawPass(uint32_t key, GLuint inputTexture, QOpenGLFramebufferObject& target,
+                           int width, int height, const QRect& scissor, GLuint sharpenTexture) {
     // Bind framebuffer
-    m_fbo->bind();
+    target.bind();
     
     // Set viewport
-    glViewport(0, 0, m_width, m_height);
+    glViewport(0, 0, width, height);
+    
+    // Restrict shading (and the clear) to the requested pixels
+    if (!scissor.isNull()) {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(scissor.x(), scissor.y(), scissor.width(), scissor.height());
+    }
     
     // Clear
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
     
-    // Use shader
-    m_shader->bind();
-    
-    // Set uniforms (bypass all adjustments if showing "before")
-    m_shader->setUniform("inputTexture", 0);
-    m_shader->setUniform("exposure", m_bypassAdjustments ? 0.0f : m_exposure);
-    m_shader->setUniform("contrast", m_bypassAdjustments ? 0.0f : m_contrast);
-    m_shader->setUniform("sharpness", m_bypassAdjustments ? 0.0f : m_sharpness);
-    m_shader->setUniform("temperature", m_bypassAdjustments ? 0.0f : m_temperature);
-    m_shader->setUniform("tint", m_bypassAdjustments ? 0.0f : m_tint);
-    m_shader->setUniform("highlights", m_bypassAdjustments ? 0.0f : m_highlights);
-    m_shader->setUniform("shadows", m_bypassAdjustments ? 0.0f : m_shadows);
-    m_shader->setUniform("vibrance", m_bypassAdjustments ? 0.0f : m_vibrance);
-    m_shader->setUniform("saturation", m_bypassAdjustments ? 0.0f : m_saturation);
-    m_shader->setUniform("highlightContrast", m_bypassAdjustments ? 0.0f : m_highlightContrast);
-    m_shader->setUniform("midtoneContrast", m_bypassAdjustments ? 0.0f : m_midtoneContrast);
-    m_shader->setUniform("shadowContrast", m_bypassAdjustments ? 0.0f : m_shadowContrast);
-    m_shader->setUniform("whites", m_bypassAdjustments ? 0.0f : m_whites);
-    m_shader->setUniform("blacks", m_bypassAdjustments ? 0.0f : m_blacks);
-    m_shader->setUniform("texelSize", 1.0f / m_width, 1.0f / m_height);
-    m_shader->setUniform("outputMode", m_outputMode);
-    
-    // Bind texture
+    // Use the variant compiled for the pass's stages
+    ShaderProgram* shader = developShader(key);
+    if (!shader) {
+        if (!scissor.isNull()) {
+            glDisable(GL_SCISSOR_TEST);
+        }
+        target.release();
+        return false;
+    }
+    shader->bind();
+    
+    // Bind textures
+    bool useLut = key & kApplyLut;
+    if (useLut) {
+        shader->setUniform("lutSize", m_lutSize);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_3D, m_lutTexture);
+    }
+    if (sharpenTexture) {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, sharpenTexture);
+    }
     glActiveTexture(GL_TEXTURE0);
-    m_inputTexture->bind();
+    glBindTexture(GL_TEXTURE_2D, inputTexture);
     
     // Render quad
     renderQuad();
     
     // Cleanup
-    m_inputTexture->release();
-    m_shader->release();
-    m_fbo->release();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (useLut) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_3D, 0);
+    }
+    if (sharpenTexture) {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    if (!scissor.isNull()) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+    shader->release();
+    target.release();
+    return true;
+}
+
+void GPUPipeline::uploadParameters() {
+    // "Before" renders run with every adjustment at zero
+    DevelopParams params = {};
+    if (!m_bypassAdjustments) {
+        params.exposure = m_exposure;
+        params.contrast = m_contrast;
+        params.sharpness = m_sharpness;
+        params.temperature = m_temperature;
+        params.tint = m_tint;
+        params.highlights = m_highlights;
+        params.shadows = m_shadows;
+        params.vibrance = m_vibrance;
+        params.saturation = m_saturation;
+        params.highlightContrast = m_highlightContrast;
+        params.midtoneContrast = m_midtoneContrast;
+        params.shadowContrast = m_shadowContrast;
+        params.whites = m_whites;
+        params.blacks = m_blacks;
+    }
+    params.outputMode = m_outputMode;
+    
+    // Rebound every time: the GUI shares its context with other GL code
+    glBindBufferBase(GL_UNIFORM_BUFFER, kParamsBinding, m_paramsBuffer);
+    if (m_paramsUploaded && std::memcmp(&params, &m_uploadedParams, sizeof(params)) == 0) {
+        return;
+    }
     
+    glBindBuffer(GL_UNIFORM_BUFFER, m_paramsBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(params), &params);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    m_uploadedParams = params;
+    m_paramsUploaded = true;
+}
+
+std::vector<float> GPUPipeline::lutParameters() const {
+    // Everything the color chain depends on (sharpening is applied after it)
+    return {m_exposure, m_contrast, m_temperature, m_tint, m_highlights, m_shadows,
+            m_vibrance, m_saturation, m_highlightContrast, m_midtoneContrast,
+            m_shadowContrast, m_whites, m_blacks, static_cast<float>(m_outputMode)};
+}
+
+bool GPUPipeline::useColorLut() const {
+    // The lattice is uniform in linear input, too coarse in the shadows
+    // for the tone and output curves to be exact; "before" renders skip
+    // the adjustments anyway
+    return m_interactive && !m_exactRender && m_lutInputNormalized && !m_bypassAdjustments;
+}
+
+bool GPUPipeline::bakeLut(int size, std::vector<float>* readback) {
+    // Exported LUTs are read back, so bake those at full float precision
+    GLenum format = readback ? GL_RGBA32F : kWorkingFormat;
+    if (!m_lutTexture) {
+        glGenTextures(1, &m_lutTexture);
+        glGenFramebuffers(1, &m_lutFramebuffer);
+    }
+    if (size != m_lutSize || format != m_lutFormat) {
+        glBindTexture(GL_TEXTURE_3D, m_lutTexture);
+        glTexImage3D(GL_TEXTURE_3D, 0, format, size, size, size, 0, GL_RGBA, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_3D, 0);
+        m_lutSize = size;
+        m_lutFormat = format;
+    }
+    m_lutParameters.clear();
+    
+    // The direct variant for the current settings minus sharpening, shading
+    // lattice points instead of texels
+    ShaderProgram* shader = developShader((shaderVariantKey() & ~kStageSharpening) | kBakeLut);
+    if (!shader) {
+        return false;
+    }
+    
+    if (readback) {
+        readback->resize(static_cast<size_t>(size) * size * size * 4);
+    }
+    
+    // One pass per blue slice; red runs along x and green along y
+    glBindFramebuffer(GL_FRAMEBUFFER, m_lutFramebuffer);
+    glViewport(0, 0, size, size);
+    uploadParameters();
+    shader->bind();
+    shader->setUniform("lutSize", size);
+    bool complete = true;
+    for (int slice = 0; slice < size && complete; ++slice) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_lutTexture, 0, slice);
+        if (slice == 0 && glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Color LUT framebuffer incomplete" << std::endl;
+            complete = false;
+            break;
+        }
+        shader->setUniform("lutSlice", slice);
+        renderQuad();
+        if (readback) {
+            size_t sliceFloats = static_cast<size_t>(size) * size * 4;
+            glReadPixels(0, 0, size, size, GL_RGBA, GL_FLOAT, readback->data() + slice * sliceFloats);
+        }
+    }
+    shader->release();
+    QOpenGLFramebufferObject::bindDefault();
+    
+    if (complete) {
+        m_lutParameters = lutParameters();
+    }
+    return complete;
+}
+
+bool GPUPipeline::exportCubeLut(const std::string& path, int size) {
+    if (!isInitialized()) {
+        std::cerr << "Pipeline not initialized" << std::endl;
+        return false;
+    }
+    if (size < 2 || size > 256) {
+        std::cerr << "LUT size must be between 2 and 256" << std::endl;
+        return false;
+    }
+    
+    std::vector<float> lut;
+    bool baked = bakeLut(size, &lut);
+    // Display renders rebake at their own size and precision
+    m_lutParameters.clear();
+    if (!baked) {
+        return false;
+    }
+    
+    std::string error;
+    if (!writeCubeLut(path, lut, size, "ZRaw Developer", &error)) {
+        std::cerr << error << std::endl;
+        return false;
+    }
+    
+    std::cout << "Exported " << size << "^3 color LUT to " << path << std::endl;
+    return true;
+}
+
+bool GPUPipeline::computeStatistics(ImageStatistics& stats, int bins, bool proxy) {
+    if (!hasImage()) {
+        std::cerr << "No image to measure" << std::endl;
+        return false;
+    }
+    if (bins < 2 || bins > 4096) {
+        std::cerr << "Histogram bins must be between 2 and 4096" << std::endl;
+        return false;
+    }
+    
+    // Rendered regions to measure: the proxy, the full frame, or the tile
+    // interiors of an oversize image (tiles overlap only in their aprons)
+    bool useProxy = proxy && m_proxyFbo;
+    std::vector<QRect> regions;
+    if (useProxy) {
+        regions.push_back(QRect(0, 0, m_proxyWidth, m_proxyHeight));
+    } else if (m_tiledSource) {
+        regions = tileGrid();
+    } else {
+        regions.push_back(QRect(0, 0, m_width, m_height));
+    }
+    
+    int chunks = 0;
+    for (const QRect& region : regions) {
+        qint64 pixels = static_cast<qint64>(region.width()) * region.height();
+        chunks += static_cast<int>((pixels + kStatsChunkPixels - 1) / kStatsChunkPixels);
+    }
+    int targetWidth = std::max(bins, kStatsClipMasks);
+    int targetHeight = chunks * kStatsRowsPerChunk;
+    auto target = m_resources.acquireFramebuffer(targetWidth, targetHeight, GL_R32F);
+    target->bind();
+    glViewport(0, 0, targetWidth, targetHeight);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    target->release();
+    
+    int row = 0;
+    if (useProxy) {
+        renderPass(m_proxyInputFbo->texture(), *m_proxyFbo, m_proxyWidth, m_proxyHeight);
+        scatterStatistics(m_proxyFbo->texture(), regions.front(), bins, row, *target);
+    } else if (m_tiledSource) {
+        m_exactRender = true;
+        for (const QRect& interior : regions) {
+            QRect padded;
+            auto tile = uploadTile(interior, padded);
+            if (!tile) {
+                m_exactRender = false;
+                m_resources.recycle(std::move(target));
+                return false;
+            }
+            auto tileTarget = m_resources.acquireFramebuffer(padded.width(), padded.height(), kWorkingFormat);
+            renderPass(tile->textureId(), *tileTarget, padded.width(), padded.height());
+            scatterStatistics(tileTarget->texture(), interior.translated(-padded.topLeft()), bins, row,
+                              *target);
+            m_resources.recycle(std::move(tile));
+            m_resources.recycle(std::move(tileTarget));
+        }
+        m_exactRender = false;
+    } else {
+        renderFullFrame();
+        scatterStatistics(m_fbo->texture(), regions.front(), bins, row, *target);
+    }
+    
+    // Only the bins come back: a few KB however large the image
+    std::vector<float> counts(static_cast<size_t>(targetWidth) * targetHeight);
+    target->bind();
+    glReadPixels(0, 0, targetWidth, targetHeight, GL_RED, GL_FLOAT, counts.data());
+    target->release();
+    m_resources.recycle(std::move(target));
+    
+    stats = ImageStatistics();
+    stats.width = useProxy ? m_proxyWidth : m_width;
+    stats.height = useProxy ? m_proxyHeight : m_height;
+    stats.bins = bins;
+    std::vector<uint64_t>* histograms[4] = {&stats.red, &stats.green, &stats.blue, &stats.luminance};
+    for (std::vector<uint64_t>* histogram : histograms) {
+        histogram->assign(bins, 0);
+    }
+    uint64_t masks[kStatsClipMasks] = {};
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        const float* rows = &counts[static_cast<size_t>(chunk) * kStatsRowsPerChunk * targetWidth];
+        for (int channel = 0; channel < 4; ++channel) {
+            for (int bin = 0; bin < bins; ++bin) {
+                float count = rows[channel * targetWidth + bin];
+                (*histograms[channel])[bin] += static_cast<uint64_t>(std::llround(count));
+            }
+        }
+        for (int mask = 0; mask < kStatsClipMasks; ++mask) {
+            masks[mask] += static_cast<uint64_t>(std::llround(rows[4 * targetWidth + mask]));
+        }
+    }
+    
+    // Clip masks: bits 0-2 highlights, 3-5 shadows (red, green, blue)
+    for (int mask = 0; mask < kStatsClipMasks; ++mask) {
+        for (int channel = 0; channel < 3; ++channel) {
+            if (mask & (1 << channel)) stats.highlightsClipped[channel] += masks[mask];
+            if (mask & (8 << channel)) stats.shadowsClipped[channel] += masks[mask];
+        }
+        if (mask & 7) stats.highlightPixels += masks[mask];
+        if (mask & 56) stats.shadowPixels += masks[mask];
+    }
     return true;
 }
 
+void GPUPipeline::scatterStatistics(GLuint texture, const QRect& region, int bins, int& row,
+                                    QOpenGLFramebufferObject& target) {
+    target.bind();
+    glViewport(0, 0, target.width(), target.height());
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFunc(GL_ONE, GL_ONE);
+    
+    m_statsShader->bind();
+    m_statsShader->setUniform("inputTexture", 0);
+    m_statsShader->setUniform("regionOrigin", region.x(), region.y());
+    m_statsShader->setUniform("regionWidth", region.width());
+    m_statsShader->setUniform("bins", bins);
+    m_statsShader->setUniform("targetSize", static_cast<float>(target.width()),
+                              static_cast<float>(target.height()));
+    m_statsShader->setUniform("clipShadow", kClipShadow);
+    m_statsShader->setUniform("clipHighlight", kClipHighlight);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindVertexArray(m_statsVao);
+    
+    qint64 pixels = static_cast<qint64>(region.width()) * region.height();
+    for (qint64 first = 0; first < pixels; first += kStatsChunkPixels) {
+        m_statsShader->setUniform("firstPixel", static_cast<int>(first));
+        m_statsShader->setUniform("firstRow", row);
+        GLsizei count = static_cast<GLsizei>(std::min<qint64>(pixels - first, kStatsChunkPixels));
+        glDrawArraysInstanced(GL_POINTS, 0, count, kStatsRowsPerChunk);
+        row += kStatsRowsPerChunk;
+    }
+    
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_statsShader->release();
+    glDisable(GL_BLEND);
+    target.release();
+}
+
 void GPUPipeline::renderQuad() {
     glBindVertexArray(m_vao);
     glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -1137,29 +2513,138 @@ void GPUPipeline::renderQuad() {
 }
 
 std::shared_ptr<ImageBuffer> GPUPipeline::downloadImage() {
+    return downloadImage(PixelType::UInt16);
+}
+
+std::shared_ptr<ImageBuffer> GPUPipeline::downloadImage(PixelType type) {
+    if (m_tiledSource) {
+        return renderTiles(type);
+    }
     if (!m_fbo) {
         return nullptr;
     }
     
-    auto buffer = std::make_shared<ImageBuffer>(m_width, m_height, 3);
+    renderFullFrame();
+    
+    // Read back RGBA (the driver's fast path) and drop alpha in parallel
+    ImageBuffer padded(m_width, m_height, 4, type);
     
     m_fbo->bind();
-    glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_SHORT, buffer->data());
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, glPixelType(type), padded.bytes());
     m_fbo->release();
     
+    auto buffer = std::make_shared<ImageBuffer>(m_width, m_height, 3, type);
+    stripAlpha(padded.view(), buffer->view());
+    
     return buffer;
 }
 
+bool GPUPipeline::beginDownload() {
+    // Tiled images download synchronously, tile by tile
+    if (m_tiledSource || !m_fbo || m_pendingDownloads.size() >= static_cast<size_t>(kTransferSlots)) {
+        return false;
+    }
+    
+    renderFullFrame();
+    
+    // Slots are reused round-robin and never while still pending
+    int slot = m_downloadSlot;
+    m_downloadSlot = (m_downloadSlot + 1) % kTransferSlots;
+    TransferBuffer& readback = m_downloadBuffers[slot];
+    
+    size_t bytes = static_cast<size_t>(m_width) * m_height * 4 * sizeof(uint16_t);
+    reserveTransferBuffer(readback, GL_PIXEL_PACK_BUFFER, bytes, GL_STREAM_READ);
+    m_fbo->bind();
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_SHORT, nullptr);
+    m_fbo->release();
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.width = m_width;
+    readback.height = m_height;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    
+    // Submit now so the copy runs while the caller prepares the next image
+    glFlush();
+    m_pendingDownloads.push_back(slot);
+    return true;
+}
+
+std::shared_ptr<ImageBuffer> GPUPipeline::finishDownload() {
+    if (m_pendingDownloads.empty()) {
+        return nullptr;
+    }
+    
+    TransferBuffer& readback = m_downloadBuffers[m_pendingDownloads.front()];
+    m_pendingDownloads.pop_front();
+    waitForFence(readback.fence);
+    
+    int width = readback.width;
+    int height = readback.height;
+    size_t rowBytes = static_cast<size_t>(width) * 4 * sizeof(uint16_t);
+    
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rowBytes * height, GL_MAP_READ_BIT);
+    std::shared_ptr<ImageBuffer> buffer;
+    if (mapped) {
+        buffer = std::make_shared<ImageBuffer>(width, height, 3);
+        stripAlpha(ConstImageView(static_cast<const uint8_t*>(mapped), width, height, 4, rowBytes),
+                   buffer->view());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        std::cerr << "Failed to map readback buffer" << std::endl;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    
+    return buffer;
+}
+
+void GPUPipeline::renderFullFrame() {
+    // The last render may have been a preview or gone through the display
+    // LUT; export needs the full frame through the exact color chain
+    if (!m_fullFrameCurrent || !m_fullFrameExact) {
+        m_exactRender = true;
+        renderPass(m_inputTexture->textureId(), *m_fbo, m_width, m_height);
+        m_exactRender = false;
+        m_fullFrameCurrent = true;
+        m_fullFrameExact = true;
+        m_renderedRegion = QRect(0, 0, m_width, m_height);
+    }
+}
+
+void GPUPipeline::reserveTransferBuffer(TransferBuffer& buffer, GLenum target, size_t bytes,
+                                        GLenum usage) {
+    if (!buffer.pbo) {
+        glGenBuffers(1, &buffer.pbo);
+    }
+    glBindBuffer(target, buffer.pbo);
+    if (buffer.bytes != bytes) {
+        glBufferData(target, static_cast<GLsizeiptr>(bytes), nullptr, usage);
+        buffer.bytes = bytes;
+    }
+}
+
+void GPUPipeline::waitForFence(GLsync& fence) {
+    if (!fence) {
+        return;
+    }
+    
+    // Flush on the first wait so the fence is guaranteed to be submitted
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (glClientWaitSync(fence, flags, 1000000000) == GL_TIMEOUT_EXPIRED) {
+        flags = 0;
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
 GLuint GPUPipeline::getOutputTexture() const {
     // Return original texture when showing "before", otherwise return processed output
     if (m_bypassAdjustments && m_originalTexture) {
-        GLuint texId = m_originalTexture->textureId();
-        std::cout << "Returning original texture: " << texId << std::endl;
-        return texId;
+        return m_originalTexture->textureId();
+    }
+    if (m_showingProxy && m_proxyFbo) {
+        return m_proxyFbo->texture();
     }
-    GLuint texId = m_fbo ? m_fbo->texture() : 0;
-    std::cout << "Returning processed texture: " << texId << std::endl;
-    return texId;
+    return m_fbo ? m_fbo->texture() : 0;
 }
 
 } // namespace zraw
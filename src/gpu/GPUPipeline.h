@@ -2,12 +2,23 @@
 
 #include "ShaderProgram.h"
 #include "GLContext.h"
+#include "ShaderCache.h"
+#include "GPUResourceCache.h"
 #include "../core/ImageBuffer.h"
+#include "../core/ImageStatistics.h"
+#include "../core/RenderBackend.h"
 #include <QOpenGLTexture>
 #include <QOpenGLFramebufferObject>
 #include <QOpenGLExtraFunctions>
+#include <QRect>
+#include <QRectF>
+#include <QRegion>
+#include <deque>
 #include <memory>
 #include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace zraw {
 
@@ -15,62 +26,204 @@ namespace zraw {
  * GPU processing pipeline
  * Manages textures, framebuffers, and shader execution
  */
-class GPUPipeline : protected QOpenGLExtraFunctions {
+class GPUPipeline : public RenderBackend, protected QOpenGLExtraFunctions {
 public:
     GPUPipeline();
-    ~GPUPipeline();
+    ~GPUPipeline() override;
 
     // Initialize pipeline
-    bool initialize();
+    bool initialize() override;
     
     // Check if initialized
     bool isInitialized() const { return m_context && m_context->isInitialized(); }
     
     // Upload image to GPU
-    bool uploadImage(std::shared_ptr<ImageBuffer> buffer);
+    bool uploadImage(std::shared_ptr<ImageBuffer> buffer) override;
     
     // Apply adjustments
-    void setExposure(float exposure);
-    void setContrast(float contrast);
-    void setSharpness(float sharpness);
-    void setTemperature(float temperature);
-    void setTint(float tint);
-    void setHighlights(float highlights);
-    void setShadows(float shadows);
-    void setVibrance(float vibrance);
-    void setSaturation(float saturation);
-    void setHighlightContrast(float highlightContrast);
-    void setMidtoneContrast(float midtoneContrast);
-    void setShadowContrast(float shadowContrast);
-    void setWhites(float whites);
-    void setBlacks(float blacks);
+    void setExposure(float exposure) override;
+    void setContrast(float contrast) override;
+    void setSharpness(float sharpness) override;
+    
+    // Sharpening radius (Gaussian sigma in pixels, 0.5-4.0, default 0.7)
+    void setSharpenRadius(float radius) override;
+    float sharpenRadius() const { return m_sharpenRadius; }
+    
+    void setTemperature(float temperature) override;
+    void setTint(float tint) override;
+    void setHighlights(float highlights) override;
+    void setShadows(float shadows) override;
+    void setVibrance(float vibrance) override;
+    void setSaturation(float saturation) override;
+    void setHighlightContrast(float highlightContrast) override;
+    void setMidtoneContrast(float midtoneContrast) override;
+    void setShadowContrast(float shadowContrast) override;
+    void setWhites(float whites) override;
+    void setBlacks(float blacks) override;
     
     // Output mode: 0=SDR, 1=HDR PQ, 2=HDR HLG, 3=Full ACES
-    void setOutputMode(int mode);
+    void setOutputMode(int mode) override;
     
     // Before/After toggle
-    void setBypassAdjustments(bool bypass);
+    void setBypassAdjustments(bool bypass) override;
+    
+    // Preview mode: process() renders a downsampled proxy of the image
+    // (interactive slider drags); downloadImage() always returns full resolution
+    void setPreviewMode(bool enabled);
+    bool previewMode() const { return m_previewMode; }
+    
+    // Interactive mode (the viewer): display renders may approximate the
+    // color chain with the baked LUT. Downloads, and every render outside
+    // interactive mode, run the exact chain
+    void setInteractive(bool interactive) { m_interactive = interactive; }
+    bool interactive() const { return m_interactive; }
+    
+    // Region of interest in normalized texture coordinates (0-1, t=0 is the
+    // first image row). process() shades only this part of the full frame;
+    // downloadImage() renders the rest on demand
+    void setRegionOfInterest(const QRectF& region);
+    void clearRegionOfInterest() { setRegionOfInterest(QRectF(0.0, 0.0, 1.0, 1.0)); }
+    
+    // Mark the last render stale (settings changed); the next needsRender()
+    // reports true so the display coalesces many changes into one process()
+    void invalidate();
+    
+    // True if settings changed since the last process() or the region of
+    // interest is not covered by the last render
+    bool needsRender() const;
     
     // Process image with current settings
-    bool process();
+    bool process() override;
+    
+    // Download processed image from GPU (16-bit integer for the exporters)
+    std::shared_ptr<ImageBuffer> downloadImage() override;
+    
+    // Download in a given sample format; float formats read the half-float
+    // render target without quantizing to 16-bit integers
+    std::shared_ptr<ImageBuffer> downloadImage(PixelType type);
     
-    // Download processed image from GPU
-    std::shared_ptr<ImageBuffer> downloadImage();
+    // Asynchronous readback through a pixel buffer object and fence
+    bool beginDownload() override;
+    std::shared_ptr<ImageBuffer> finishDownload() override;
     
     // Get texture for rendering
     GLuint getOutputTexture() const;
     
     // Get image dimensions
-    int width() const { return m_width; }
-    int height() const { return m_height; }
+    int width() const override { return m_width; }
+    int height() const override { return m_height; }
+    
+    // True if the image exceeds the texture size limit: it is displayed
+    // through the proxy and downloaded in overlapping tiles
+    bool isTiled() const { return m_tiledSource != nullptr; }
+    
+    // Bake the current color adjustments and output transform into a
+    // size^3 LUT and write it as a .cube file for other tools (sharpening
+    // works on neighbourhoods and is not part of it)
+    bool exportCubeLut(const std::string& path, int size = 33);
+    
+    // Histograms (2-4096 bins) and clip counts of the processed image,
+    // gathered on the GPU; only the bins are read back. The full frame is
+    // rendered first if the last render didn't cover it. proxy measures the
+    // preview proxy instead (the full frame for images too small for one)
+    bool computeStatistics(ImageStatistics& stats, int bins = 256, bool proxy = false);
 
 private:
     std::unique_ptr<GLContext> m_context;
-    std::unique_ptr<ShaderProgram> m_shader;
+    std::unique_ptr<ShaderCache> m_shaderCache;  // Linked program binaries on disk
+    // Develop shader variants keyed by enabled stages and output mode,
+    // compiled on first use
+    std::map<uint32_t, std::unique_ptr<ShaderProgram>> m_shaderVariants;
+    GPUResourceCache m_resources;  // Declared before the objects it recycles
     std::unique_ptr<QOpenGLTexture> m_inputTexture;
     std::unique_ptr<QOpenGLTexture> m_originalTexture;  // Store original for before/after
     std::unique_ptr<QOpenGLFramebufferObject> m_fbo;
     
+    // Downsampled proxy used in preview mode
+    std::unique_ptr<ShaderProgram> m_downsampleShader;
+    std::unique_ptr<QOpenGLFramebufferObject> m_proxyInputFbo;  // Downsampled source image
+    std::unique_ptr<QOpenGLFramebufferObject> m_proxyFbo;       // Processed proxy
+    int m_proxyWidth;
+    int m_proxyHeight;
+    bool m_previewMode;
+    bool m_showingProxy;      // Last process() rendered the proxy
+    bool m_fullFrameCurrent;  // m_fbo holds a render of the current settings
+    bool m_fullFrameExact;    // ...rendered without the color LUT
+    bool m_interactive;
+    bool m_exactRender;       // Set while rendering for a download
+    bool m_dirty;             // Settings changed since the last process()
+    
+    // Sharpening prepasses: luminance, then a separable Gaussian blur
+    std::unique_ptr<ShaderProgram> m_sharpenLumaShader;
+    std::unique_ptr<ShaderProgram> m_blurShader;
+    
+    // Histogram scatter; its points read pixels with texelFetch, so the
+    // VAO has no attributes
+    std::unique_ptr<ShaderProgram> m_statsShader;
+    GLuint m_statsVao;
+    
+    // Double-buffered pixel buffer objects for transfers that don't block
+    // the calling thread: while the GPU copies one image, the CPU fills or
+    // drains the other
+    static const int kTransferSlots = 2;
+    struct TransferBuffer {
+        GLuint pbo = 0;
+        size_t bytes = 0;
+        GLsync fence = nullptr;  // Signalled once the GPU is done with pbo
+        int width = 0;
+        int height = 0;
+    };
+    TransferBuffer m_uploadBuffers[kTransferSlots];
+    TransferBuffer m_downloadBuffers[kTransferSlots];
+    int m_uploadSlot;
+    int m_downloadSlot;
+    std::deque<int> m_pendingDownloads;  // Slots with queued readbacks, oldest first
+    
+    // Tiled rendering of oversize images
+    std::shared_ptr<ImageBuffer> m_tiledSource;  // Set while the image is tiled
+    int m_maxTextureSize;
+    int m_proxyFactor;  // Full-resolution pixels per proxy pixel
+    
+    // 3D LUT of the develop shader's per-pixel color chain, rebaked when the
+    // settings change so full-frame passes cost one lookup per pixel. Raw GL
+    // objects: each slice is rendered through a layer attachment
+    GLuint m_lutTexture;
+    GLuint m_lutFramebuffer;
+    int m_lutSize;
+    GLenum m_lutFormat;
+    bool m_lutInputNormalized;           // Input lies in the LUT's 0-1 domain
+    std::vector<float> m_lutParameters;  // Settings the LUT was baked for
+    
+    // Intermediate render targets of the develop passes, per render size
+    // (full frame, proxy, tile). Hashes chain the source image and every
+    // earlier pass's parameters, so a cached output is reused only if
+    // nothing upstream of it changed. Their bytes count against the
+    // resource cache's limit, and only half of it is kept between renders:
+    // least recently used sizes go first, then the current size's passes,
+    // the input of its last pass last
+    struct PassCache {
+        std::unique_ptr<QOpenGLFramebufferObject> fbo;
+        size_t hash = 0;
+        QRegion valid;  // Pixels rendered with hash
+    };
+    struct PassCacheSet {
+        std::vector<PassCache> passes;
+        uint64_t lastUse = 0;
+        int lastInput = -1;  // Slot whose output the last pass read
+    };
+    std::map<std::pair<int, int>, PassCacheSet> m_passCaches;
+    uint64_t m_passCacheUse;
+    
+    // Ping-pong targets of renders that skip the pass caches: color chain
+    // intermediates and sharpening prepasses
+    std::unique_ptr<QOpenGLFramebufferObject> m_scratchTargets[2];
+    std::unique_ptr<QOpenGLFramebufferObject> m_sharpenScratch[2];
+    uint64_t m_sourceGeneration;  // Bumped whenever source pixels change
+    
+    // Viewport-only rendering
+    QRectF m_regionOfInterest;  // Normalized, clamped to the image
+    QRect m_renderedRegion;     // Pixels of m_fbo shaded by the last process()
+    
     int m_width;
     int m_height;
     
@@ -78,6 +231,7 @@ private:
     float m_exposure;
     float m_contrast;
     float m_sharpness;
+    float m_sharpenRadius;
     float m_temperature;
     float m_tint;
     float m_highlights;
@@ -96,12 +250,72 @@ private:
     // Before/After state
     bool m_bypassAdjustments;
     
+    // Adjustment parameters in the layout of the develop shader's std140
+    // DevelopParams block: scalars packed at 4-byte offsets, size rounded
+    // up to 16 bytes
+    struct DevelopParams {
+        float exposure;
+        float contrast;
+        float sharpness;
+        float temperature;
+        float tint;
+        float highlights;
+        float shadows;
+        float vibrance;
+        float saturation;
+        float highlightContrast;
+        float midtoneContrast;
+        float shadowContrast;
+        float whites;
+        float blacks;
+        int32_t outputMode;
+        float padding;
+    };
+    static_assert(sizeof(DevelopParams) == 64, "DevelopParams must match the std140 block");
+    GLuint m_paramsBuffer;
+    DevelopParams m_uploadedParams;  // Contents of m_paramsBuffer
+    bool m_paramsUploaded;
+    
     // Vertex buffer for fullscreen quad
     GLuint m_vao;
     GLuint m_vbo;
     
     bool createShaders();
+    uint32_t shaderVariantKey() const;
+    ShaderProgram* developShader(uint32_t key);
+    void uploadParameters();
+    std::vector<float> lutParameters() const;
+    bool useColorLut() const;
+    bool bakeLut(int size, std::vector<float>* readback = nullptr);
     bool createBuffers();
+    bool createProxy();
+    bool hasImage() const { return m_tiledSource ? m_proxyFbo != nullptr : m_fbo != nullptr; }
+    bool uploadTiled(std::shared_ptr<ImageBuffer> buffer);
+    size_t workingSetBytes() const;  // VRAM of one image's textures and proxies
+    bool stageUpload(QOpenGLTexture& texture, const ConstImageView& source);
+    void createOriginal(GLuint input, QOpenGLFramebufferObject& target, int width, int height);
+    std::vector<QRect> tileGrid() const;
+    std::unique_ptr<QOpenGLTexture> uploadTile(const QRect& interior, QRect& padded);
+    std::shared_ptr<ImageBuffer> renderTiles(PixelType type);
+    QRect regionPixels() const;
+    void renderFullFrame();
+    void reserveTransferBuffer(TransferBuffer& buffer, GLenum target, size_t bytes, GLenum usage);
+    void waitForFence(GLsync& fence);
+    void renderPass(GLuint inputTexture, QOpenGLFramebufferObject& target, int width, int height,
+                    const QRect& scissor = QRect());
+    std::vector<int> developPasses(bool useLut) const;
+    uint32_t passKey(int pass, bool last) const;
+    size_t passHash(int pass, uint32_t key) const;
+    bool drawPass(uint32_t key, GLuint inputTexture, QOpenGLFramebufferObject& target, int width,
+                  int height, const QRect& scissor, GLuint sharpenTexture = 0);
+    GLuint prepareSharpening(GLuint input, std::vector<PassCache>* caches, size_t inputHash,
+                             float sigma, int taps, int width, int height, const QRect& region);
+    QOpenGLFramebufferObject& scratchTarget(std::unique_ptr<QOpenGLFramebufferObject>& slot,
+                                            int width, int height, GLenum format);
+    void releasePassCaches();
+    void trimPassCaches();
+    void scatterStatistics(GLuint texture, const QRect& region, int bins, int& row,
+                           QOpenGLFramebufferObject& target);
     void renderQuad();
 };
 
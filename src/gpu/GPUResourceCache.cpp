@@ -0,0 +1,138 @@
+#include "GPUResourceCache.h"
+#include <algorithm>
+
+namespace zraw {
+
+namespace {
+
+// Approximate VRAM footprint, used only for the byte limit
+size_t bytesPerPixel(GLenum format) {
+    switch (format) {
+        case GL_RGBA32F:
+            return 16;
+        case GL_RGBA16F:
+        case GL_RGBA16:
+        case GL_RG32F:
+            return 8;
+        case GL_RGB16:
+        case GL_RGB16F:
+            return 6;
+        case GL_R32F:
+            return 4;
+        default:
+            return 4;
+    }
+}
+
+} // namespace
+
+GPUResourceCache::GPUResourceCache(size_t idleByteLimit)
+    : m_idleByteLimit(idleByteLimit), m_heldBytes(0), m_useCounter(0) {
+}
+
+GPUResourceCache::~GPUResourceCache() {
+    clear();
+}
+
+template <typename T>
+std::unique_ptr<T> GPUResourceCache::takeIdle(std::vector<Entry<T>>& entries, const Key& key) {
+    ++m_stats.requests;
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->key == key) {
+            std::unique_ptr<T> object = std::move(it->object);
+            entries.erase(it);
+            m_stats.bytesIdle -= byteSize(key.width, key.height, key.format);
+            ++m_stats.hits;
+            return object;
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<QOpenGLTexture> GPUResourceCache::acquireTexture(int width, int height, GLenum format) {
+    if (auto texture = takeIdle(m_textures, Key{width, height, format})) {
+        return texture;
+    }
+
+    auto texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2D);
+    texture->setFormat(static_cast<QOpenGLTexture::TextureFormat>(format));
+    texture->setSize(width, height);
+    texture->allocateStorage();
+    texture->setMinificationFilter(QOpenGLTexture::Linear);
+    texture->setMagnificationFilter(QOpenGLTexture::Linear);
+    texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    return texture;
+}
+
+std::unique_ptr<QOpenGLFramebufferObject> GPUResourceCache::acquireFramebuffer(int width, int height,
+                                                                               GLenum format) {
+    if (auto framebuffer = takeIdle(m_framebuffers, Key{width, height, format})) {
+        return framebuffer;
+    }
+
+    QOpenGLFramebufferObjectFormat fboFormat;
+    fboFormat.setInternalTextureFormat(format);
+    return std::make_unique<QOpenGLFramebufferObject>(width, height, fboFormat);
+}
+
+void GPUResourceCache::recycle(std::unique_ptr<QOpenGLTexture> texture) {
+    if (!texture) {
+        return;
+    }
+    Key key{texture->width(), texture->height(), static_cast<GLenum>(texture->format())};
+    m_stats.bytesIdle += byteSize(key.width, key.height, key.format);
+    m_textures.push_back({key, std::move(texture), ++m_useCounter});
+    trim();
+}
+
+void GPUResourceCache::recycle(std::unique_ptr<QOpenGLFramebufferObject> framebuffer) {
+    if (!framebuffer) {
+        return;
+    }
+    Key key{framebuffer->width(), framebuffer->height(),
+            static_cast<GLenum>(framebuffer->format().internalTextureFormat())};
+    m_stats.bytesIdle += byteSize(key.width, key.height, key.format);
+    m_framebuffers.push_back({key, std::move(framebuffer), ++m_useCounter});
+    trim();
+}
+
+void GPUResourceCache::trim() {
+    while (m_stats.bytesIdle + m_heldBytes > m_idleByteLimit && (!m_textures.empty() || !m_framebuffers.empty())) {
+        // Oldest entry of either list goes first
+        bool evictTexture = !m_textures.empty() &&
+            (m_framebuffers.empty() || m_textures.front().lastUse < m_framebuffers.front().lastUse);
+        const Key& key = evictTexture ? m_textures.front().key : m_framebuffers.front().key;
+        m_stats.bytesIdle -= byteSize(key.width, key.height, key.format);
+        if (evictTexture) {
+            m_textures.erase(m_textures.begin());
+        } else {
+            m_framebuffers.erase(m_framebuffers.begin());
+        }
+    }
+}
+
+void GPUResourceCache::clear() {
+    m_textures.clear();
+    m_framebuffers.clear();
+    m_stats.bytesIdle = 0;
+}
+
+void GPUResourceCache::setHeldBytes(size_t bytes) {
+    m_heldBytes = bytes;
+    trim();
+}
+
+void GPUResourceCache::setIdleByteLimit(size_t bytes) {
+    m_idleByteLimit = bytes;
+    trim();
+}
+
+size_t GPUResourceCache::byteSize(int width, int height, GLenum format) {
+    return static_cast<size_t>(width) * height * bytesPerPixel(format);
+}
+
+GPUResourceCache::Stats GPUResourceCache::stats() const {
+    return m_stats;
+}
+
+} // namespace zraw
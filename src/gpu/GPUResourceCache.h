@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QOpenGLTexture>
+#include <QOpenGLFramebufferObject>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace zraw {
+
+/**
+ * Recycles textures and framebuffer objects between images
+ * Objects handed back with recycle() are kept idle, keyed by (width, height,
+ * internal format), and returned by the next acquire with the same key, so
+ * a batch of same-camera images allocates its GPU storage once. Contents of
+ * a recycled object are undefined. Idle objects beyond the byte limit, less
+ * the bytes held elsewhere, are deleted, least recently recycled first. All calls need the owning OpenGL
+ * context to be current, including destruction.
+ */
+class GPUResourceCache {
+public:
+    struct Stats {
+        uint64_t requests = 0;  // acquire*() calls
+        uint64_t hits = 0;      // acquire*() calls served from idle objects
+        size_t bytesIdle = 0;   // Estimated VRAM held by idle objects
+    };
+
+    static constexpr size_t kDefaultIdleByteLimit = size_t(512) << 20;
+
+    explicit GPUResourceCache(size_t idleByteLimit = kDefaultIdleByteLimit);
+    ~GPUResourceCache();
+
+    GPUResourceCache(const GPUResourceCache&) = delete;
+    GPUResourceCache& operator=(const GPUResourceCache&) = delete;
+
+    // 2D texture with linear filtering and clamp-to-edge wrapping
+    std::unique_ptr<QOpenGLTexture> acquireTexture(int width, int height, GLenum format);
+    std::unique_ptr<QOpenGLFramebufferObject> acquireFramebuffer(int width, int height, GLenum format);
+
+    // Hand an object back for reuse (null is ignored)
+    void recycle(std::unique_ptr<QOpenGLTexture> texture);
+    void recycle(std::unique_ptr<QOpenGLFramebufferObject> framebuffer);
+
+    // Delete all idle objects
+    void clear();
+
+    // Bytes of long-lived objects held outside the cache (such as the
+    // pipeline's pass intermediates) that count against the idle limit
+    void setHeldBytes(size_t bytes);
+    void setIdleByteLimit(size_t bytes);
+    size_t idleByteLimit() const { return m_idleByteLimit; }
+
+    // Approximate VRAM footprint of a width x height image in format
+    static size_t byteSize(int width, int height, GLenum format);
+
+    Stats stats() const;
+
+private:
+    struct Key {
+        int width;
+        int height;
+        GLenum format;
+
+        bool operator==(const Key& other) const {
+            return width == other.width && height == other.height && format == other.format;
+        }
+    };
+
+    template <typename T>
+    struct Entry {
+        Key key;
+        std::unique_ptr<T> object;
+        uint64_t lastUse;
+    };
+
+    template <typename T>
+    std::unique_ptr<T> takeIdle(std::vector<Entry<T>>& entries, const Key& key);
+    void trim();
+
+    size_t m_idleByteLimit;
+    size_t m_heldBytes;
+    uint64_t m_useCounter;
+    Stats m_stats;
+    std::vector<Entry<QOpenGLTexture>> m_textures;
+    std::vector<Entry<QOpenGLFramebufferObject>> m_framebuffers;
+};
+
+} // namespace zraw
@@ -0,0 +1,123 @@
+#include "ShaderCache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace zraw {
+
+namespace {
+
+// File header: magic and the driver's binary format
+const char kMagic[4] = {'Z', 'R', 'S', 'B'};
+const int kHeaderSize = 8;
+
+} // namespace
+
+ShaderCache::ShaderCache(const std::string& driverId)
+    : m_driverId(driverId), m_enabled(false) {
+    initializeOpenGLFunctions();
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) {
+        std::cout << "Shader cache disabled: driver has no program binary formats" << std::endl;
+        return;
+    }
+
+    // GenericCacheLocation is $XDG_CACHE_HOME, or ~/.cache if unset
+    m_directory = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+                  "/zraw-developer/shaders";
+    if (!QDir().mkpath(m_directory)) {
+        std::cerr << "Shader cache disabled: cannot create " << m_directory.toStdString() << std::endl;
+        return;
+    }
+
+    m_enabled = true;
+    std::cout << "Shader cache: " << m_directory.toStdString() << std::endl;
+}
+
+std::string ShaderCache::key(const std::string& vertexSource, const std::string& fragmentSource) const {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    // Lengths keep the boundaries between the parts unambiguous
+    for (const std::string* part : {&m_driverId, &vertexSource, &fragmentSource}) {
+        uint64_t length = part->size();
+        hash.addData(QByteArrayView(reinterpret_cast<const char*>(&length), sizeof(length)));
+        hash.addData(QByteArrayView(part->data(), static_cast<qsizetype>(part->size())));
+    }
+    return hash.result().toHex().toStdString();
+}
+
+bool ShaderCache::load(const std::string& key, GLuint program) {
+    if (!m_enabled) {
+        return false;
+    }
+
+    QFile file(path(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray data = file.readAll();
+    file.close();
+
+    if (data.size() <= kHeaderSize || std::memcmp(data.constData(), kMagic, sizeof(kMagic)) != 0) {
+        QFile::remove(path(key));
+        return false;
+    }
+
+    uint32_t format = 0;
+    std::memcpy(&format, data.constData() + sizeof(kMagic), sizeof(format));
+    glProgramBinary(program, format, data.constData() + kHeaderSize,
+                    static_cast<GLsizei>(data.size() - kHeaderSize));
+
+    // Drivers may refuse binaries of an older build with the same version string
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        QFile::remove(path(key));
+        return false;
+    }
+    return true;
+}
+
+void ShaderCache::store(const std::string& key, GLuint program) {
+    if (!m_enabled) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    QByteArray data(kHeaderSize + length, Qt::Uninitialized);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, data.data() + kHeaderSize);
+    if (written <= 0) {
+        return;
+    }
+    uint32_t format32 = format;
+    std::memcpy(data.data(), kMagic, sizeof(kMagic));
+    std::memcpy(data.data() + sizeof(kMagic), &format32, sizeof(format32));
+
+    // Written to a temporary file and renamed, so concurrent processes
+    // never read a partial binary
+    QSaveFile file(path(key));
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(data.constData(), kHeaderSize + written) != kHeaderSize + written ||
+        !file.commit()) {
+        std::cerr << "Failed to write shader cache entry " << key << std::endl;
+    }
+}
+
+QString ShaderCache::path(const std::string& key) const {
+    return m_directory + "/" + QString::fromStdString(key) + ".bin";
+}
+
+} // namespace zraw
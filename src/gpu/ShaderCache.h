@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+#include <QString>
+#include <string>
+
+namespace zraw {
+
+/**
+ * On-disk cache of linked shader program binaries
+ * Programs are stored under $XDG_CACHE_HOME/zraw-developer/shaders (usually
+ * ~/.cache), keyed by a hash of their sources and the driver's vendor,
+ * renderer and version string, so a driver update or a changed shader is
+ * a cache miss rather than a stale binary. Binaries the driver rejects are
+ * deleted. All calls need the OpenGL context current.
+ */
+class ShaderCache : protected QOpenGLExtraFunctions {
+public:
+    // driverId identifies the driver (vendor, renderer and version)
+    explicit ShaderCache(const std::string& driverId);
+
+    // False if the driver has no binary formats or the directory is not writable
+    bool isEnabled() const { return m_enabled; }
+
+    // Cache key of a program built from these sources
+    std::string key(const std::string& vertexSource, const std::string& fragmentSource) const;
+
+    // Load a cached binary into program; true if it is now linked
+    bool load(const std::string& key, GLuint program);
+
+    // Save a linked program's binary (linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+    void store(const std::string& key, GLuint program);
+
+private:
+    std::string m_driverId;
+    QString m_directory;
+    bool m_enabled;
+
+    QString path(const std::string& key) const;
+};
+
+} // namespace zraw
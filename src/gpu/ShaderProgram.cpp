@@ -1,10 +1,17 @@
 #include "ShaderProgram.h"
+#include "ShaderCache.h"
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <algorithm>
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 namespace zraw {
 
 ShaderProgram::ShaderProgram()
-    : m_program(std::make_unique<QOpenGLShaderProgram>()) {
+    : m_program(std::make_unique<QOpenGLShaderProgram>())
+    , m_loadedFromCache(false) {
 }
 
 ShaderProgram::~ShaderProgram() {
@@ -31,6 +38,57 @@ bool ShaderProgram::link() {
         setError("Failed to link shader program: " + m_program->log().toStdString());
         return false;
     }
+    
+    // Resolve every active uniform now instead of on each set
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+    GLuint program = m_program->programId();
+    GLint count = 0;
+    GLint maxLength = 0;
+    gl->glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    gl->glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(static_cast<size_t>(std::max(maxLength, 1)));
+    m_uniformLocations.clear();
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        gl->glGetActiveUniform(program, static_cast<GLuint>(i), maxLength, &length, &size, &type, name.data());
+        // Members of uniform blocks have no location
+        int location = m_program->uniformLocation(name.data());
+        if (location >= 0) {
+            m_uniformLocations.emplace(std::string(name.data(), length), location);
+        }
+    }
+    return true;
+}
+
+bool ShaderProgram::build(const std::string& vertexSource, const std::string& fragmentSource,
+                          ShaderCache* cache) {
+    m_loadedFromCache = false;
+    std::string key;
+    if (cache && cache->isEnabled() && m_program->create()) {
+        key = cache->key(vertexSource, fragmentSource);
+        // QOpenGLShaderProgram::link() accepts a program without shaders
+        // that is already linked from a binary
+        if (cache->load(key, m_program->programId()) && link()) {
+            m_loadedFromCache = true;
+            return true;
+        }
+    }
+    
+    if (!loadVertexShader(vertexSource) || !loadFragmentShader(fragmentSource)) {
+        return false;
+    }
+    if (!key.empty()) {
+        QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+        gl->glProgramParameteri(m_program->programId(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    if (!link()) {
+        return false;
+    }
+    if (!key.empty()) {
+        cache->store(key, m_program->programId());
+    }
     return true;
 }
 
@@ -43,19 +101,54 @@ void ShaderProgram::release() {
 }
 
 void ShaderProgram::setUniform(const char* name, float value) {
-    m_program->setUniformValue(name, value);
+    int location = uniformLocation(name);
+    if (location >= 0) {
+        m_program->setUniformValue(location, value);
+    }
 }
 
 void ShaderProgram::setUniform(const char* name, int value) {
-    m_program->setUniformValue(name, value);
+    int location = uniformLocation(name);
+    if (location >= 0) {
+        m_program->setUniformValue(location, value);
+    }
 }
 
 void ShaderProgram::setUniform(const char* name, float x, float y) {
-    m_program->setUniformValue(name, x, y);
+    int location = uniformLocation(name);
+    if (location >= 0) {
+        m_program->setUniformValue(location, x, y);
+    }
+}
+
+void ShaderProgram::setUniform(const char* name, int x, int y) {
+    // QOpenGLShaderProgram has no integer vector setters
+    int location = uniformLocation(name);
+    if (location >= 0) {
+        QOpenGLContext::currentContext()->functions()->glUniform2i(location, x, y);
+    }
 }
 
 void ShaderProgram::setUniform(const char* name, float x, float y, float z) {
-    m_program->setUniformValue(name, x, y, z);
+    int location = uniformLocation(name);
+    if (location >= 0) {
+        m_program->setUniformValue(location, x, y, z);
+    }
+}
+
+int ShaderProgram::uniformLocation(const char* name) const {
+    auto it = m_uniformLocations.find(std::string_view(name));
+    return it != m_uniformLocations.end() ? it->second : -1;
+}
+
+bool ShaderProgram::bindUniformBlock(const char* name, GLuint binding) {
+    QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+    GLuint index = gl->glGetUniformBlockIndex(m_program->programId(), name);
+    if (index == GL_INVALID_INDEX) {
+        return false;
+    }
+    gl->glUniformBlockBinding(m_program->programId(), index, binding);
+    return true;
 }
 
 GLuint ShaderProgram::programId() const {
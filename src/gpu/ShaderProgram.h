@@ -3,13 +3,17 @@
 #include <string>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions>
+#include <map>
 #include <memory>
 
 namespace zraw {
 
+class ShaderCache;
+
 /**
  * Wrapper for OpenGL shader programs
- * Handles compilation and uniform management
+ * Handles compilation and uniform management. Uniform locations are
+ * resolved once at link time, so setting a uniform costs no driver lookup
  */
 class ShaderProgram {
 public:
@@ -21,16 +25,31 @@ public:
     bool loadFragmentShader(const std::string& source);
     bool link();
     
+    // Compile and link both stages, or load the program from cache if given
+    bool build(const std::string& vertexSource, const std::string& fragmentSource,
+               ShaderCache* cache = nullptr);
+    
+    // True if the last build() was served from the binary cache
+    bool loadedFromCache() const { return m_loadedFromCache; }
+    
     // Use shader
     void bind();
     void release();
     
-    // Set uniforms
+    // Set uniforms (names that aren't active in the program are ignored)
     void setUniform(const char* name, float value);
     void setUniform(const char* name, int value);
     void setUniform(const char* name, float x, float y);
+    void setUniform(const char* name, int x, int y);
     void setUniform(const char* name, float x, float y, float z);
     
+    // Location of an active uniform, -1 if the program doesn't use it
+    int uniformLocation(const char* name) const;
+    
+    // Attach a uniform block to a buffer binding point
+    // @return false if the program doesn't use the block
+    bool bindUniformBlock(const char* name, GLuint binding);
+    
     // Get program ID
     GLuint programId() const;
     
@@ -39,7 +58,9 @@ public:
 
 private:
     std::unique_ptr<QOpenGLShaderProgram> m_program;
+    std::map<std::string, int, std::less<>> m_uniformLocations;
     std::string m_lastError;
+    bool m_loadedFromCache;
     
     void setError(const std::string& error);
 };
@@ -0,0 +1,94 @@
+#include "TransferBenchmark.h"
+#include "../core/ImageBuffer.h"
+#include "../core/PixelPacking.h"
+#include <chrono>
+#include <iostream>
+
+namespace zraw {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double megabytesPerSecond(size_t bytes, int iterations, Clock::duration elapsed) {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0.0 ? bytes * static_cast<double>(iterations) / (seconds * 1e6) : 0.0;
+}
+
+} // namespace
+
+bool TransferBenchmark::run(int width, int height, int iterations, Result& result) {
+    initializeOpenGLFunctions();
+
+    ImageBuffer rgb(width, height, 3);
+    ImageBuffer rgba(width, height, 4);
+    uint16_t* pixels = rgb.data();
+    for (size_t i = 0; i < rgb.size(); ++i) {
+        pixels[i] = static_cast<uint16_t>(i * 2654435761u >> 16);
+    }
+
+    // Same target format as GPUPipeline's input texture and render targets
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+
+    GLuint fbo = 0;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    // Tightly packed RGB rows are not 4-byte aligned for odd widths
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    if (complete) {
+        // Warm up driver allocations before timing
+        padToRGBA(rgb.view(), rgba.view());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_SHORT, rgba.bytes());
+        glFinish();
+
+        const size_t bytes = rgb.byteSize();
+
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_SHORT, rgb.bytes());
+            glFinish();
+        }
+        result.uploadRGB = megabytesPerSecond(bytes, iterations, Clock::now() - start);
+
+        start = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            padToRGBA(rgb.view(), rgba.view());
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_SHORT, rgba.bytes());
+            glFinish();
+        }
+        result.uploadRGBA = megabytesPerSecond(bytes, iterations, Clock::now() - start);
+
+        start = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_SHORT, rgb.bytes());
+        }
+        result.downloadRGB = megabytesPerSecond(bytes, iterations, Clock::now() - start);
+
+        start = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_SHORT, rgba.bytes());
+            stripAlpha(rgba.view(), rgb.view());
+        }
+        result.downloadRGBA = megabytesPerSecond(bytes, iterations, Clock::now() - start);
+    } else {
+        std::cerr << "Transfer benchmark: framebuffer incomplete" << std::endl;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &texture);
+    return complete;
+}
+
+} // namespace zraw
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+
+namespace zraw {
+
+/**
+ * Measures texture upload and framebuffer readback throughput
+ * Compares the driver's 3-channel 16-bit path with padding to RGBA on the
+ * CPU first (what GPUPipeline does), on a synthetic image. Needs a current
+ * OpenGL context.
+ */
+class TransferBenchmark : protected QOpenGLExtraFunctions {
+public:
+    struct Result {
+        double uploadRGB = 0.0;    // MB/s of RGB image data
+        double uploadRGBA = 0.0;   // Including padToRGBA()
+        double downloadRGB = 0.0;
+        double downloadRGBA = 0.0; // Including stripAlpha()
+    };
+
+    /**
+     * Run every transfer `iterations` times and report the mean throughput
+     * @return false if the texture or framebuffer could not be created
+     */
+    bool run(int width, int height, int iterations, Result& result);
+};
+
+} // namespace zraw
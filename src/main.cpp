@@ -1,44 +1,249 @@
 #include <QApplication>
+#include <QGuiApplication>
 #include <QSurfaceFormat>
-#include <QOffscreenSurface>
-#include <QOpenGLContext>
+#include <QDir>
+#include <chrono>
+#include <csignal>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include "ui/MainWindow.h"
 #include "core/CLIHandler.h"
 #include "core/RawProcessor.h"
 #include "core/ImageExporter.h"
+#include "core/BatchProcessor.h"
+#include "core/BufferPool.h"
+#include "core/RenderServer.h"
+#include "gpu/GLContext.h"
 #include "gpu/GPUPipeline.h"
+#include "gpu/TransferBenchmark.h"
+#include "cpu/CpuPipeline.h"
 
-// Headless processing mode
-int runHeadless(const zraw::CLIHandler::Options& options) {
-    // Create offscreen OpenGL context for GPU processing
-    QSurfaceFormat format;
-    format.setVersion(3, 3);
-    format.setProfile(QSurfaceFormat::CoreProfile);
-    QSurfaceFormat::setDefaultFormat(format);
+// Create and initialize the render backend selected with --backend
+// (the GPU backend needs a current OpenGL context)
+std::shared_ptr<zraw::RenderBackend> createBackend(const zraw::CLIHandler::Options& options) {
+    std::shared_ptr<zraw::RenderBackend> backend;
+    if (options.backend == "cpu") {
+        backend = std::make_shared<zraw::CpuPipeline>();
+    } else {
+        backend = std::make_shared<zraw::GPUPipeline>();
+    }
+    
+    if (!backend->initialize()) {
+        std::cerr << "Failed to initialize " << options.backend.toStdString() << " pipeline" << std::endl;
+        return nullptr;
+    }
+    
+    // Settings outside the per-job adjustments
+    backend->setSharpenRadius(options.sharpenRadius);
+    return backend;
+}
+
+// Report image buffer reuse at the end of a batch or daemon run
+void printBufferPoolStats() {
+    auto stats = zraw::BufferPool::instance().stats();
+    std::cout << "Buffer pool: " << stats.bytesAllocated / (1024 * 1024) << " MiB allocated, "
+              << stats.poolHits << "/" << stats.requests << " requests reused" << std::endl;
+}
+
+// Batch processing mode: one warm context and pipeline for many files
+int runBatch(const zraw::CLIHandler::Options& options,
+             const std::shared_ptr<zraw::RenderBackend>& pipeline) {
+    QStringList inputs = zraw::BatchProcessor::collectInputs(options.batchInput);
+    if (inputs.isEmpty()) {
+        std::cerr << "No RAW files found for batch input: "
+                  << options.batchInput.toStdString() << std::endl;
+        return 1;
+    }
+    
+    QDir outputDir(options.outputFile);
+    if (!outputDir.mkpath(".")) {
+        std::cerr << "Failed to create output directory: "
+                  << options.outputFile.toStdString() << std::endl;
+        return 1;
+    }
+    
+    auto format = zraw::ImageExporter::formatFromString(options.format);
+    QString extension = zraw::ImageExporter::extensionForFormat(format);
+    QStringList outputNames = zraw::BatchProcessor::outputBaseNames(inputs);
+    
+    zraw::XMPHandler::Adjustments adjustments;
+    adjustments.exposure = options.exposure;
+    adjustments.contrast = options.contrast;
+    adjustments.sharpness = options.sharpness;
+    
+    zraw::BatchProcessor::Settings settings;
+    settings.decodeThreads = options.decodeThreads;
+    settings.encodeThreads = options.encodeThreads;
+    
+    zraw::BatchProcessor processor(pipeline, settings);
+    processor.start();
+    
+    std::cout << "Batch processing " << inputs.size() << " files" << std::endl;
+    
+    std::mutex logMutex;
+    int finished = 0;
+    auto onComplete = [&](const zraw::BatchProcessor::Result& result) {
+        std::lock_guard<std::mutex> lock(logMutex);
+        ++finished;
+        std::cout << "[" << finished << "/" << inputs.size() << "] "
+                  << result.inputFile.toStdString();
+        if (result.success) {
+            std::cout << " -> " << result.outputFile.toStdString()
+                      << " (decode " << result.decodeMs << " ms, render " << result.renderMs
+                      << " ms, encode " << result.encodeMs << " ms)" << std::endl;
+        } else {
+            std::cout << " FAILED: " << result.error << std::endl;
+        }
+    };
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    // Feed jobs from a separate thread; this thread renders
+    std::thread feeder([&]() {
+        for (int i = 0; i < inputs.size(); ++i) {
+            zraw::BatchProcessor::Job job;
+            job.inputFile = inputs[i];
+            job.outputFile = outputDir.filePath(outputNames[i] + "." + extension);
+            job.adjustments = adjustments;
+            job.decodeOptions = options.decodeOptions;
+            job.format = format;
+            job.quality = options.quality;
+            if (!processor.submit(job, onComplete)) {
+                break;
+            }
+        }
+        processor.finish();
+    });
+    
+    processor.runRenderLoop();
+    feeder.join();
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Batch complete: " << processor.completedCount() << " succeeded, "
+              << processor.failedCount() << " failed in " << seconds << " s ("
+              << (seconds > 0.0 ? processor.completedCount() / seconds : 0.0)
+              << " images/s)" << std::endl;
+    printBufferPoolStats();
+    
+    return processor.failedCount() == 0 ? 0 : 1;
+}
+
+// Daemon mode: serve render jobs over a Unix socket until SIGINT/SIGTERM
+static zraw::RenderServer* g_renderServer = nullptr;
+
+void handleStopSignal(int) {
+    if (g_renderServer) {
+        g_renderServer->stop();
+    }
+}
+
+int runServer(const zraw::CLIHandler::Options& options,
+              const std::shared_ptr<zraw::RenderBackend>& pipeline) {
+    zraw::BatchProcessor::Settings settings;
+    settings.decodeThreads = options.decodeThreads;
+    settings.encodeThreads = options.encodeThreads;
+    
+    zraw::BatchProcessor processor(pipeline, settings);
+    processor.start();
+    
+    zraw::RenderServer server(processor);
+    if (!server.listen(options.serveSocket)) {
+        std::cerr << "Failed to start render server: " << server.lastError() << std::endl;
+        return 1;
+    }
+    
+    g_renderServer = &server;
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+    
+    // Render on this thread (it owns the GL context, if any) until the server stops
+    processor.runRenderLoop();
+    server.wait();
     
-    QOpenGLContext context;
-    context.setFormat(format);
-    if (!context.create()) {
-        std::cerr << "Failed to create OpenGL context" << std::endl;
+    g_renderServer = nullptr;
+    std::cout << "Render server stopped after " << processor.completedCount() << " jobs ("
+              << processor.failedCount() << " failed)" << std::endl;
+    printBufferPoolStats();
+    if (server.failed()) {
+        std::cerr << "Render server failed: " << server.lastError() << std::endl;
         return 1;
     }
+    return 0;
+}
+
+// Benchmark mode: RGB vs. padded RGBA texture transfers on a 24 MP image
+int runTransferBenchmark() {
+    const int width = 6000;
+    const int height = 4000;
+    const int iterations = 10;
     
-    QOffscreenSurface surface;
-    surface.setFormat(format);
-    surface.create();
+    zraw::TransferBenchmark benchmark;
+    zraw::TransferBenchmark::Result result;
+    if (!benchmark.run(width, height, iterations, result)) {
+        return 1;
+    }
     
-    if (!surface.isValid()) {
-        std::cerr << "Failed to create offscreen surface" << std::endl;
+    auto report = [](const char* name, double rgb, double rgba) {
+        std::cout << "  " << name << ": RGB " << static_cast<int>(rgb) << " MB/s, padded RGBA "
+                  << static_cast<int>(rgba) << " MB/s (" << (rgb > 0.0 ? rgba / rgb : 0.0)
+                  << "x)" << std::endl;
+    };
+    std::cout << "Transfer throughput, " << width << "x" << height << " 16-bit RGB, "
+              << iterations << " iterations:" << std::endl;
+    report("Upload  ", result.uploadRGB, result.uploadRGBA);
+    report("Download", result.downloadRGB, result.downloadRGBA);
+    return 0;
+}
+
+// LUT export mode: bake the command-line adjustments into a .cube file
+int runLutExport(const zraw::CLIHandler::Options& options) {
+    zraw::GPUPipeline pipeline;
+    if (!pipeline.initialize()) {
+        std::cerr << "Failed to initialize gpu pipeline" << std::endl;
         return 1;
     }
     
-    if (!context.makeCurrent(&surface)) {
-        std::cerr << "Failed to make OpenGL context current" << std::endl;
+    pipeline.setExposure(options.exposure);
+    pipeline.setContrast(options.contrast);
+    
+    if (!pipeline.exportCubeLut(options.exportLut.toStdString())) {
+        std::cerr << "Failed to export LUT: " << options.exportLut.toStdString() << std::endl;
         return 1;
     }
+    return 0;
+}
+
+// Headless processing mode
+// results receives the --stats JSON (stdout; std::cout is stderr then)
+int runHeadless(const zraw::CLIHandler::Options& options, std::ostream& results) {
+    // Create offscreen OpenGL context for GPU processing (not needed on the CPU backend)
+    std::unique_ptr<zraw::HeadlessGLContext> context;
+    if (options.backend == "gpu" || options.benchmarkTransfers) {
+        context = std::make_unique<zraw::HeadlessGLContext>();
+        if (!context->create()) {
+            return 1;
+        }
+    }
     
-    std::cout << "OpenGL context created successfully" << std::endl;
+    if (options.benchmarkTransfers) {
+        return runTransferBenchmark();
+    }
+    
+    if (!options.exportLut.isEmpty()) {
+        return runLutExport(options);
+    }
+    
+    if (!options.batchInput.isEmpty() || !options.serveSocket.isEmpty()) {
+        auto pipeline = createBackend(options);
+        if (!pipeline) {
+            return 1;
+        }
+        if (!options.serveSocket.isEmpty()) {
+            return runServer(options, pipeline);
+        }
+        return runBatch(options, pipeline);
+    }
     
     std::cout << "Processing: " << options.inputFile.toStdString() << std::endl;
     
@@ -49,41 +254,56 @@ int runHeadless(const zraw::CLIHandler::Options& options) {
         return 1;
     }
     
-    if (!rawProcessor->processToRGB()) {
+    if (!rawProcessor->processToRGB(options.decodeOptions)) {
         std::cerr << "Failed to process RAW data: " << rawProcessor->lastError() << std::endl;
         return 1;
     }
     
-    // Create GPU pipeline
-    auto gpuPipeline = std::make_shared<zraw::GPUPipeline>();
-    if (!gpuPipeline->initialize()) {
-        std::cerr << "Failed to initialize GPU pipeline" << std::endl;
+    // Create render pipeline
+    auto pipeline = createBackend(options);
+    if (!pipeline) {
         return 1;
     }
     
-    if (!gpuPipeline->uploadImage(rawProcessor->getImageBuffer())) {
-        std::cerr << "Failed to upload image to GPU" << std::endl;
+    if (!pipeline->uploadImage(rawProcessor->getImageBuffer())) {
+        std::cerr << "Failed to upload image to " << options.backend.toStdString() << " pipeline" << std::endl;
         return 1;
     }
     
     // Apply adjustments
-    gpuPipeline->setExposure(options.exposure);
-    gpuPipeline->setContrast(options.contrast);
-    gpuPipeline->setSharpness(options.sharpness);
+    pipeline->setExposure(options.exposure);
+    pipeline->setContrast(options.contrast);
+    pipeline->setSharpness(options.sharpness);
     
     std::cout << "Applying adjustments:" << std::endl;
     std::cout << "  Exposure:  " << options.exposure << " EV" << std::endl;
     std::cout << "  Contrast:  " << options.contrast << std::endl;
     std::cout << "  Sharpness: " << options.sharpness << std::endl;
+    std::cout << "  Radius:    " << options.sharpenRadius << " px" << std::endl;
     
     // Process
-    if (!gpuPipeline->process()) {
+    if (!pipeline->process()) {
         std::cerr << "Failed to process image" << std::endl;
         return 1;
     }
     
+    // Histograms and clipping on one line, measured on the GPU
+    if (!options.stats.isEmpty()) {
+        auto gpu = std::dynamic_pointer_cast<zraw::GPUPipeline>(pipeline);
+        zraw::ImageStatistics stats;
+        if (!gpu || !gpu->computeStatistics(stats, options.statsBins, options.statsProxy)) {
+            std::cerr << "Failed to compute image statistics" << std::endl;
+            return 1;
+        }
+        results << stats.toJson() << std::endl;
+        
+        if (options.outputFile.isEmpty()) {
+            return 0;
+        }
+    }
+    
     // Download processed image
-    auto processedBuffer = gpuPipeline->downloadImage();
+    auto processedBuffer = pipeline->downloadImage();
     if (!processedBuffer) {
         std::cerr << "Failed to download processed image" << std::endl;
         return 1;
@@ -114,6 +334,7 @@ int runGUI(const zraw::CLIHandler::Options& options) {
     
     // Create main window
     zraw::MainWindow window;
+    window.setDecodeOptions(options.decodeOptions);
     window.show();
     
     // Load image if provided
@@ -127,24 +348,42 @@ int runGUI(const zraw::CLIHandler::Options& options) {
 }
 
 int main(int argc, char* argv[]) {
-    std::cout << "Starting ZRaw Developer..." << std::endl;
-    
-    QCoreApplication::setApplicationName("ZRaw Developer");
-    QCoreApplication::setApplicationVersion("0.1.0");
-    
     // Quick check for headless mode before creating Qt app
     bool isHeadless = false;
+    bool statsRequested = false;
     for (int i = 1; i < argc; ++i) {
-        if (std::string(argv[i]) == "--headless") {
+        std::string arg(argv[i]);
+        bool stats = arg == "--stats" || arg.rfind("--stats=", 0) == 0;
+        statsRequested = statsRequested || stats;
+        if (stats || arg == "--headless" || arg == "--batch" || arg.rfind("--batch=", 0) == 0 ||
+            arg == "--serve" || arg.rfind("--serve=", 0) == 0 || arg == "--benchmark-transfers" ||
+            arg == "--export-lut" || arg.rfind("--export-lut=", 0) == 0) {
             isHeadless = true;
-            break;
         }
     }
     
+    // With --stats, stdout carries only the JSON line for scripts; all
+    // progress logging goes to stderr
+    std::streambuf* stdoutBuffer = std::cout.rdbuf();
+    if (statsRequested) {
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+    std::ostream results(stdoutBuffer);
+    
+    std::cout << "Starting ZRaw Developer..." << std::endl;
+    
+    QCoreApplication::setApplicationName("ZRaw Developer");
+    QCoreApplication::setApplicationVersion("0.1.0");
+    
     if (isHeadless) {
         std::cout << "Running in headless mode" << std::endl;
-        // Headless mode - use QCoreApplication
-        QCoreApplication app(argc, argv);
+        // Headless mode - QOpenGLContext needs a QGuiApplication, but the
+        // offscreen platform doesn't connect to a display server; OpenGL
+        // comes from a surfaceless EGL context
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+        QGuiApplication app(argc, argv);
         
         zraw::CLIHandler cli;
         if (!cli.parse(QCoreApplication::arguments())) {
@@ -152,7 +391,9 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         
-        return runHeadless(cli.options());
+        int result = runHeadless(cli.options(), results);
+        std::cout.rdbuf(stdoutBuffer);
+        return result;
     } else {
         std::cout << "Running in GUI mode" << std::endl;
         // GUI mode or help - use QApplication
@@ -291,6 +291,8 @@ QWidget* AdjustmentPanel::createSliderRow(const QString& name, QSlider** slider,
     resettableSlider->setValue(defaultVal);
     resettableSlider->setDefaultValue(defaultVal);
     *slider = resettableSlider;
+    connect(resettableSlider, &QSlider::sliderPressed, this, &AdjustmentPanel::interactionStarted);
+    connect(resettableSlider, &QSlider::sliderReleased, this, &AdjustmentPanel::interactionFinished);
     (*slider)->setStyleSheet(
         "QSlider::groove:horizontal {"
         "  background: #1a1a1a;"
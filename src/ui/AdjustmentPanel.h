@@ -67,6 +67,10 @@ signals:
     void shadowContrastChanged(float value);
     void whitesChanged(float value);
     void blacksChanged(float value);
+    
+    // A slider drag started / ended (used to switch to preview rendering)
+    void interactionStarted();
+    void interactionFinished();
 
 private:
     QSlider* m_exposureSlider;
@@ -73,6 +73,7 @@ void main() {
 ImageViewer::ImageViewer(QWidget* parent)
     : QOpenGLWidget(parent),
       m_displayVAO(0), m_displayVBO(0), m_displayShader(0),
+      m_zoomLocation(-1), m_panOffsetLocation(-1), m_aspectRatioLocation(-1),
       m_zoom(1.0f), m_panOffset(0.0f, 0.0f),
       m_isPanning(false),
       m_viewportX(0), m_viewportY(0), m_viewportWidth(0), m_viewportHeight(0),
@@ -187,6 +188,15 @@ void ImageViewer::paintGL() {
     glClear(GL_COLOR_BUFFER_BIT);
     
     if (m_pipeline) {
+        // All renders happen here, at most once per displayed frame: any
+        // number of adjustment changes since the last paint collapse into one
+        // pass, as does whatever part of the image just came into view. The
+        // "before" view shows the pre-rendered original and needs no pass
+        m_pipeline->setRegionOfInterest(visibleRegion());
+        if (!m_showBefore && m_pipeline->needsRender()) {
+            m_pipeline->process();
+        }
+        
         GLuint texture = m_pipeline->getOutputTexture();
         if (texture) {
             // Use the stored viewport dimensions scaled by device pixel ratio
@@ -263,6 +273,14 @@ bool ImageViewer::createDisplayShader() {
     glDeleteShader(vertShader);
     glDeleteShader(fragShader);
     
+    // Look uniforms up once; the sampler always reads unit 0
+    m_zoomLocation = glGetUniformLocation(m_displayShader, "zoom");
+    m_panOffsetLocation = glGetUniformLocation(m_displayShader, "panOffset");
+    m_aspectRatioLocation = glGetUniformLocation(m_displayShader, "aspectRatio");
+    glUseProgram(m_displayShader);
+    glUniform1i(glGetUniformLocation(m_displayShader, "displayTexture"), 0);
+    glUseProgram(0);
+    
     return true;
 }
 
@@ -282,15 +300,12 @@ void ImageViewer::renderTexture(GLuint texture) {
     }
     
     // Set uniforms
-    glUniform1f(glGetUniformLocation(m_displayShader, "zoom"), m_zoom);
-    glUniform2f(glGetUniformLocation(m_displayShader, "panOffset"), 
-                m_panOffset.x(), m_panOffset.y());
-    glUniform2f(glGetUniformLocation(m_displayShader, "aspectRatio"),
-                imageAspect, viewportAspect);
+    glUniform1f(m_zoomLocation, m_zoom);
+    glUniform2f(m_panOffsetLocation, m_panOffset.x(), m_panOffset.y());
+    glUniform2f(m_aspectRatioLocation, imageAspect, viewportAspect);
     
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture);
-    glUniform1i(glGetUniformLocation(m_displayShader, "displayTexture"), 0);
     
     glBindVertexArray(m_displayVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -299,6 +314,34 @@ void ImageViewer::renderTexture(GLuint texture) {
     glUseProgram(0);
 }
 
+QRectF ImageViewer::visibleRegion() const {
+    if (!m_pipeline || m_pipeline->height() <= 0 || m_viewportHeight <= 0) {
+        return QRectF(0.0, 0.0, 1.0, 1.0);
+    }
+    
+    // Inverse of the display vertex shader: texture extent of the viewport
+    float imageAspect = static_cast<float>(m_pipeline->width()) / static_cast<float>(m_pipeline->height());
+    float viewportAspect = static_cast<float>(m_viewportWidth) / static_cast<float>(m_viewportHeight);
+    
+    float scaleX = 1.0f;
+    float scaleY = 1.0f;
+    if (viewportAspect > imageAspect) {
+        scaleX = viewportAspect / imageAspect;
+    } else {
+        scaleY = imageAspect / viewportAspect;
+    }
+    
+    float halfWidth = 0.5f * scaleX / m_zoom;
+    float halfHeight = 0.5f * scaleY / m_zoom;
+    
+    // Y is flipped on display, so the pan moves the other way in texture space
+    float centerX = 0.5f - m_panOffset.x() * 0.5f;
+    float centerY = 0.5f + m_panOffset.y() * 0.5f;
+    
+    QRectF region(centerX - halfWidth, centerY - halfHeight, 2.0f * halfWidth, 2.0f * halfHeight);
+    return region.intersected(QRectF(0.0, 0.0, 1.0, 1.0));
+}
+
 void ImageViewer::resetView() {
     m_zoom = 1.0f;
     m_panOffset = QPointF(0.0f, 0.0f);
@@ -45,6 +45,9 @@ private:
     GLuint m_displayVAO;
     GLuint m_displayVBO;
     GLuint m_displayShader;
+    GLint m_zoomLocation;         // Uniform locations, resolved at link time
+    GLint m_panOffsetLocation;
+    GLint m_aspectRatioLocation;
     
     // View transform state
     float m_zoom;
@@ -66,6 +69,7 @@ private:
     
     bool createDisplayShader();
     void renderTexture(GLuint texture);
+    QRectF visibleRegion() const;
     void updateTransform();
     void updateButtonPosition();
 };
@@ -5,17 +5,21 @@
 #include <QMenuBar>
 #include <QStatusBar>
 #include <QApplication>
+#include <QActionGroup>
 #include <iostream>
 
 namespace zraw {
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent),
-      m_rawProcessor(std::make_shared<RawProcessor>()),
+      m_rawLoader(std::make_unique<RawLoader>()),
       m_gpuPipeline(std::make_shared<GPUPipeline>()),
       m_xmpHandler(std::make_shared<XMPHandler>()),
       m_imageExporter(std::make_shared<ImageExporter>()),
-      m_loadingXMP(false) {
+      m_loadGeneration(0), m_shownGeneration(0),
+      m_fullImageLoaded(false),
+      m_loadingXMP(false),
+      m_interacting(false) {
     
     std::cout << "MainWindow constructor started" << std::endl;
     
@@ -28,17 +32,32 @@ MainWindow::MainWindow(QWidget* parent)
     m_xmpSaveTimer->setInterval(500);  // 500ms delay
     connect(m_xmpSaveTimer, &QTimer::timeout, this, &MainWindow::saveXMPAdjustments);
     
+    // Refine to full resolution when a drag pauses
+    m_fullRenderTimer = new QTimer(this);
+    m_fullRenderTimer->setSingleShot(true);
+    m_fullRenderTimer->setInterval(250);
+    connect(m_fullRenderTimer, &QTimer::timeout, this, &MainWindow::renderFullResolution);
+    
     std::cout << "Creating UI..." << std::endl;
     createUI();
     
     std::cout << "Creating menus..." << std::endl;
     createMenus();
     
+    // Decode progress, shown only while a file is loading
+    m_loadProgress = new QProgressBar(this);
+    m_loadProgress->setRange(0, 100);
+    m_loadProgress->setMaximumWidth(200);
+    m_loadProgress->hide();
+    statusBar()->addPermanentWidget(m_loadProgress);
+    
     statusBar()->showMessage("Ready");
     std::cout << "MainWindow constructor complete" << std::endl;
 }
 
 MainWindow::~MainWindow() {
+    // Cancel and join the decoder before anything its callbacks touch goes away
+    m_rawLoader.reset();
 }
 
 void MainWindow::createUI() {
@@ -94,6 +113,10 @@ void MainWindow::createUI() {
             this, &MainWindow::onWhitesChanged);
     connect(m_adjustmentPanel, &AdjustmentPanel::blacksChanged,
             this, &MainWindow::onBlacksChanged);
+    connect(m_adjustmentPanel, &AdjustmentPanel::interactionStarted,
+            this, &MainWindow::onInteractionStarted);
+    connect(m_adjustmentPanel, &AdjustmentPanel::interactionFinished,
+            this, &MainWindow::onInteractionFinished);
 }
 
 void MainWindow::createMenus() {
@@ -108,6 +131,36 @@ void MainWindow::createMenus() {
     saveAction->setShortcut(QKeySequence::Save);
     connect(saveAction, &QAction::triggered, this, &MainWindow::saveFile);
     
+    // The current look as a 3D LUT for other tools
+    auto* exportLutAction = fileMenu->addAction("Export &LUT...");
+    connect(exportLutAction, &QAction::triggered, this, &MainWindow::exportLut);
+    
+    // Lower decode scales skip demosaicing - fast culling and web proofs
+    auto* scaleMenu = fileMenu->addMenu("Decode &Scale");
+    auto* scaleGroup = new QActionGroup(this);
+    const std::pair<RawProcessor::DecodeScale, const char*> scales[] = {
+        {RawProcessor::DecodeScale::Full, "&Full Resolution"},
+        {RawProcessor::DecodeScale::Half, "&Half (1/2)"},
+        {RawProcessor::DecodeScale::Quarter, "&Quarter (1/4)"}
+    };
+    for (const auto& [scale, label] : scales) {
+        auto* action = scaleMenu->addAction(label);
+        action->setCheckable(true);
+        action->setChecked(scale == m_decodeOptions.scale);
+        scaleGroup->addAction(action);
+        m_decodeScaleActions.insert(scale, action);
+        connect(action, &QAction::triggered, this, [this, scale = scale]() {
+            if (scale == m_decodeOptions.scale) {
+                return;
+            }
+            m_decodeOptions.scale = scale;
+            // Re-decode the open image at the new scale
+            if (!m_currentFile.isEmpty()) {
+                loadImage(m_currentFile);
+            }
+        });
+    }
+    
     fileMenu->addSeparator();
     
     auto* quitAction = fileMenu->addAction("&Quit");
@@ -128,45 +181,114 @@ void MainWindow::openFile() {
     }
 }
 
+void MainWindow::setDecodeOptions(const RawProcessor::DecodeOptions& options) {
+    m_decodeOptions = options;
+    if (QAction* action = m_decodeScaleActions.value(options.scale)) {
+        action->setChecked(true);
+    }
+}
+
 bool MainWindow::loadImage(const QString& filepath) {
     statusBar()->showMessage("Loading " + filepath + "...");
-    
-    // Set current file BEFORE processing so XMP loading works
-    m_currentFile = filepath;
-    
-    if (!processRawFile(filepath)) {
-        QMessageBox::critical(this, "Error", "Failed to load RAW file:\n" +
-                            QString::fromStdString(m_rawProcessor->lastError()));
-        statusBar()->showMessage("Failed to load image");
-        m_currentFile.clear();  // Clear on failure
-        return false;
-    }
-    
-    setWindowTitle("ZRaw Developer - " + QFileInfo(filepath).fileName());
-    statusBar()->showMessage("Loaded " + filepath);
+    m_loadProgress->setValue(0);
+    m_loadProgress->show();
+    
+    // Decode off the GUI thread; callbacks hop back via queued invocations
+    // and are ignored once a newer load has been requested
+    uint64_t generation = ++m_loadGeneration;
+    auto deliver = [this, generation, filepath](const RawLoader::Result& result) {
+        QMetaObject::invokeMethod(this, [this, generation, filepath, result]() {
+            onImageDecoded(generation, filepath, result);
+        }, Qt::QueuedConnection);
+    };
+    m_rawLoader->load(
+        filepath.toStdString(),
+        m_decodeOptions,
+        [this, generation](float fraction) {
+            QMetaObject::invokeMethod(this, [this, generation, fraction]() {
+                onLoadProgress(generation, fraction);
+            }, Qt::QueuedConnection);
+        },
+        deliver,
+        deliver);
     
     return true;
 }
 
-bool MainWindow::processRawFile(const QString& filepath) {
-    std::cout << "Processing RAW file: " << filepath.toStdString() << std::endl;
+void MainWindow::onLoadProgress(uint64_t generation, float fraction) {
+    if (generation != m_loadGeneration) {
+        return;
+    }
+    m_loadProgress->setValue(static_cast<int>(fraction * 100.0f));
+}
+
+void MainWindow::onImageDecoded(uint64_t generation, const QString& filepath, const RawLoader::Result& result) {
+    // Superseded by a newer request
+    if (generation != m_loadGeneration) {
+        return;
+    }
     
-    // Load raw file
-    if (!m_rawProcessor->loadRaw(filepath.toStdString())) {
-        std::cerr << "Failed to load RAW file" << std::endl;
-        return false;
+    bool isFinal = !result.success || result.stage == RawLoader::Stage::Full;
+    if (isFinal) {
+        m_loadProgress->hide();
     }
     
-    std::cout << "RAW file loaded, processing to RGB..." << std::endl;
+    if (!result.success) {
+        if (result.cancelled) {
+            statusBar()->showMessage("Loading cancelled");
+            return;
+        }
+        QMessageBox::critical(this, "Error", "Failed to load RAW file:\n" +
+                            QString::fromStdString(result.error));
+        statusBar()->showMessage("Failed to load image");
+        return;
+    }
     
-    // Process to RGB
-    if (!m_rawProcessor->processToRGB()) {
-        std::cerr << "Failed to process to RGB" << std::endl;
-        return false;
+    bool firstImage = (m_shownGeneration != generation);
+    if (firstImage) {
+        // Write a pending sidecar save for the previous image before switching
+        if (m_xmpSaveTimer->isActive()) {
+            m_xmpSaveTimer->stop();
+            saveXMPAdjustments();
+        }
     }
     
-    std::cout << "RGB processing complete" << std::endl;
+    if (!uploadDecodedImage(result.image)) {
+        if (isFinal) {
+            QMessageBox::critical(this, "Error", "Failed to upload RAW file to the GPU:\n" + filepath);
+            statusBar()->showMessage("Failed to load image");
+        }
+        return;
+    }
+    m_fullImageLoaded = (result.stage == RawLoader::Stage::Full);
+    
+    if (firstImage) {
+        // The first image of a file (usually the embedded preview) switches
+        // documents; later stages only replace the pixels
+        m_shownGeneration = generation;
+        
+        // Set current file BEFORE loading the sidecar so XMP loading works
+        m_currentFile = filepath;
+        setWindowTitle("ZRaw Developer - " + QFileInfo(filepath).fileName());
+        
+        // Camera WB is already applied during RAW processing
+        // Temperature slider is for relative adjustment from camera WB
+        std::cout << "Camera WB temperature: " << result.cameraWBKelvin << "K (applied during RAW processing)" << std::endl;
+        m_adjustmentPanel->setTemperature(0.0f);  // 0 = use camera WB as-is
+        m_gpuPipeline->setTemperature(0.0f);
+        
+        std::cout << "Loading XMP adjustments..." << std::endl;
+        // Load XMP adjustments if they exist (this will override camera WB if saved)
+        loadXMPAdjustments();
+    } else {
+        m_gpuPipeline->invalidate();
+        m_viewer->updateDisplay();
+    }
     
+    statusBar()->showMessage((isFinal ? "Loaded " : "Refining ") + filepath);
+}
+
+bool MainWindow::uploadDecodedImage(const std::shared_ptr<ImageBuffer>& image) {
     // Initialize GPU pipeline if needed
     if (!m_gpuPipeline->isInitialized()) {
         std::cout << "Initializing GPU pipeline..." << std::endl;
@@ -176,37 +298,24 @@ bool MainWindow::processRawFile(const QString& filepath) {
             std::cerr << "Failed to initialize GPU pipeline" << std::endl;
             return false;
         }
+        m_gpuPipeline->setInteractive(true);
         m_viewer->doneCurrent();
         std::cout << "GPU pipeline initialized" << std::endl;
     }
     
-    // Upload to GPU
-    std::cout << "Uploading image to GPU..." << std::endl;
+    // Upload to GPU - the only part of loading that needs the GL thread
+    std::cout << "Uploading " << image->width() << "x" << image->height() << " image to GPU..." << std::endl;
     m_viewer->makeCurrent();
-    if (!m_gpuPipeline->uploadImage(m_rawProcessor->getImageBuffer())) {
+    if (!m_gpuPipeline->uploadImage(image)) {
         std::cerr << "Failed to upload image to GPU" << std::endl;
         m_viewer->doneCurrent();
         return false;
     }
-    std::cout << "Image uploaded to GPU" << std::endl;
     
     // Set pipeline in viewer
     m_viewer->setGPUPipeline(m_gpuPipeline);
     
     m_viewer->doneCurrent();
-    
-    // Camera WB is already applied during RAW processing
-    // Temperature slider is for relative adjustment from camera WB
-    float cameraWBKelvin = m_rawProcessor->getCameraWBTemperature();
-    std::cout << "Camera WB temperature: " << cameraWBKelvin << "K (applied during RAW processing)" << std::endl;
-    m_adjustmentPanel->setTemperature(0.0f);  // 0 = use camera WB as-is
-    m_gpuPipeline->setTemperature(0.0f);
-    
-    std::cout << "Loading XMP adjustments..." << std::endl;
-    // Load XMP adjustments if they exist (this will override camera WB if saved)
-    loadXMPAdjustments();
-    
-    std::cout << "Image processing complete" << std::endl;
     return true;
 }
 
@@ -216,6 +325,12 @@ void MainWindow::saveFile() {
         return;
     }
     
+    // Only a preview is on the GPU until the full demosaic finishes
+    if (!m_fullImageLoaded) {
+        QMessageBox::information(this, "Loading", "Please wait until the full-resolution image has been decoded.");
+        return;
+    }
+    
     QString filepath = QFileDialog::getSaveFileName(
         this,
         "Save Image",
@@ -253,6 +368,39 @@ void MainWindow::saveFile() {
     }
 }
 
+void MainWindow::exportLut() {
+    // The pipeline is initialized with the first image
+    if (!m_gpuPipeline->isInitialized()) {
+        QMessageBox::information(this, "No Image", "Please load an image first.");
+        return;
+    }
+    
+    QString filepath = QFileDialog::getSaveFileName(
+        this,
+        "Export LUT",
+        QString(),
+        "Cube LUT (*.cube)"
+    );
+    
+    if (filepath.isEmpty()) {
+        return;
+    }
+    if (!filepath.endsWith(".cube", Qt::CaseInsensitive)) {
+        filepath += ".cube";
+    }
+    
+    m_viewer->makeCurrent();
+    bool exported = m_gpuPipeline->exportCubeLut(filepath.toStdString());
+    m_viewer->doneCurrent();
+    
+    if (exported) {
+        statusBar()->showMessage("LUT exported to " + filepath);
+    } else {
+        QMessageBox::critical(this, "Error", "Failed to export LUT to:\n" + filepath);
+        statusBar()->showMessage("Failed to export LUT");
+    }
+}
+
 void MainWindow::onExposureChanged(float value) {
     if (m_gpuPipeline) {
         m_gpuPipeline->setExposure(value);
@@ -410,11 +558,39 @@ void MainWindow::onBlacksChanged(float value) {
     }
 }
 
+void MainWindow::onInteractionStarted() {
+    m_interacting = true;
+}
+
+void MainWindow::onInteractionFinished() {
+    m_interacting = false;
+    renderFullResolution();
+}
+
+void MainWindow::renderFullResolution() {
+    m_fullRenderTimer->stop();
+    if (!m_gpuPipeline || !m_gpuPipeline->previewMode()) {
+        return;
+    }
+    
+    // Still dragging if fired by the idle timer; the next move goes back to the proxy
+    m_gpuPipeline->setPreviewMode(false);
+    m_gpuPipeline->invalidate();
+    m_viewer->updateDisplay();
+}
+
 void MainWindow::updateImage() {
-    m_viewer->makeCurrent();
-    m_gpuPipeline->process();
+    // Render the downsampled proxy while dragging; refine once the drag
+    // is released or pauses
+    m_gpuPipeline->setPreviewMode(m_interacting);
+    if (m_interacting) {
+        m_fullRenderTimer->start();
+    }
+    
+    // Only mark the render stale - the viewer processes once on its next
+    // paint, dropping intermediate states (XMP loads, fast drags)
+    m_gpuPipeline->invalidate();
     m_viewer->updateDisplay();
-    m_viewer->doneCurrent();
 }
 
 void MainWindow::loadXMPAdjustments() {
@@ -1,13 +1,16 @@
 #pragma once
 
 #include <QMainWindow>
+#include <QMap>
 #include <QMenuBar>
+#include <QProgressBar>
 #include <QStatusBar>
 #include <QTimer>
+#include <cstdint>
 #include <memory>
 #include "ImageViewer.h"
 #include "AdjustmentPanel.h"
-#include "../core/RawProcessor.h"
+#include "../core/RawLoader.h"
 #include "../core/XMPHandler.h"
 #include "../core/ImageExporter.h"
 #include "../gpu/GPUPipeline.h"
@@ -24,12 +27,17 @@ public:
     explicit MainWindow(QWidget* parent = nullptr);
     ~MainWindow();
 
-    // Load image from command line
+    // Start decoding an image in the background (also from the command line)
+    // Any load still in progress is cancelled
     bool loadImage(const QString& filepath);
+    
+    // Decode scale and demosaic used for subsequent loads
+    void setDecodeOptions(const RawProcessor::DecodeOptions& options);
 
 private slots:
     void openFile();
     void saveFile();
+    void exportLut();
     void onExposureChanged(float value);
     void onContrastChanged(float value);
     void onSharpnessChanged(float value);
@@ -44,24 +52,37 @@ private slots:
     void onShadowContrastChanged(float value);
     void onWhitesChanged(float value);
     void onBlacksChanged(float value);
+    void onInteractionStarted();
+    void onInteractionFinished();
+    void renderFullResolution();
 
 private:
     ImageViewer* m_viewer;
     AdjustmentPanel* m_adjustmentPanel;
     
-    std::shared_ptr<RawProcessor> m_rawProcessor;
+    std::unique_ptr<RawLoader> m_rawLoader;
     std::shared_ptr<GPUPipeline> m_gpuPipeline;
     std::shared_ptr<XMPHandler> m_xmpHandler;
     std::shared_ptr<ImageExporter> m_imageExporter;
     
     QString m_currentFile;
+    uint64_t m_loadGeneration;   // Identifies the latest loadImage() request
+    uint64_t m_shownGeneration;  // Request whose image is currently displayed
+    bool m_fullImageLoaded;      // Displayed image is the full decode, not a preview
+    QProgressBar* m_loadProgress;
+    RawProcessor::DecodeOptions m_decodeOptions;
+    QMap<RawProcessor::DecodeScale, QAction*> m_decodeScaleActions;
     bool m_loadingXMP;  // Flag to prevent saving while loading
     QTimer* m_xmpSaveTimer;  // Timer for debounced XMP saving
+    bool m_interacting;  // A slider is being dragged - render the preview proxy
+    QTimer* m_fullRenderTimer;  // Idle timer for the full-resolution refine
     
     void createUI();
     void createMenus();
     void updateImage();
-    bool processRawFile(const QString& filepath);
+    void onLoadProgress(uint64_t generation, float fraction);
+    void onImageDecoded(uint64_t generation, const QString& filepath, const RawLoader::Result& result);
+    bool uploadDecodedImage(const std::shared_ptr<ImageBuffer>& image);
     void loadXMPAdjustments();
     void saveXMPAdjustments();
     void scheduleXMPSave();  // Schedule a debounced save